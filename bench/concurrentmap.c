@@ -0,0 +1,126 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "foxutils/concurrentmap.h"
+#include "foxutils/rand.h"
+#include "foxutils/xoshiro256ss.h"
+
+
+
+#define NUM_KEYS (1ul << 20)
+
+#define OPS_PER_THREAD (1ul << 20)
+
+#define MAX_THREADS 64u
+
+
+
+typedef struct Worker {
+	pthread_t thread;
+	FoxConcurrentMap * map;
+	uint64_t seed;
+} Worker;
+
+
+
+static void AddOne(
+		uint64_t * elem,
+		bool inserted,
+		void * ctx
+) {
+	(void)inserted;
+	(void)ctx;
+	(*elem)++;
+
+	return;
+}
+
+/* 90% lookups, 5% upserts, 5% removals over a shared key range. */
+static void * Work(Worker * worker) {
+	FoxConcurrentMap * map = worker->map;
+	FoxXoshiro256SS prng;
+	FoxXoshiro256SSInit(&prng, worker->seed);
+
+	for (unsigned long op = 0; op < OPS_PER_THREAD; op++) {
+		uint64_t rand = FoxXoshiro256SSNext(&prng);
+		uint64_t key = rand % NUM_KEYS;
+		unsigned int kind = (rand >> 32) % 100;
+		uint64_t elem;
+		if (kind < 90) {
+			FoxConcurrentMapIndex(map, &key, &elem);
+		} else if (kind < 95) {
+			FoxConcurrentMapUpsert(
+					map,
+					&key,
+					(void (*)(void *, bool, void *))&AddOne,
+					NULL
+			);
+		} else {
+			FoxConcurrentMapRemove(map, &key, NULL);
+		}
+	}
+
+	return NULL;
+}
+
+static double Now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+
+
+int main(void) {
+	static Worker workers[MAX_THREADS];
+
+	printf("threads  Mops/s\n");
+	for (
+			unsigned int numThreads = 1;
+			numThreads <= MAX_THREADS;
+			numThreads *= 2
+	) {
+		FoxConcurrentMap * map = FoxConcurrentMapNew(
+				sizeof(uint64_t),
+				sizeof(uint64_t),
+				FOXCONCURRENTMAP_DEF_NUMSHARDS,
+				NUM_KEYS,
+				FOXMAP_DEF_GROWRATE,
+				FOXMAP_DEF_LFTHRESH,
+				NULL,
+				NULL,
+				NULL,
+				NULL
+		);
+		for (uint64_t key = 0; key < NUM_KEYS; key += 2) {
+			FoxConcurrentMapInsert(map, &key, &key);
+		}
+
+		double start = Now();
+		for (unsigned int idx = 0; idx < numThreads; idx++) {
+			workers[idx] = (Worker){.map = map, .seed = idx};
+			pthread_create(
+					&workers[idx].thread,
+					NULL,
+					(void * (*)(void *))&Work,
+					&workers[idx]
+			);
+		}
+		for (unsigned int idx = 0; idx < numThreads; idx++) {
+			pthread_join(workers[idx].thread, NULL);
+		}
+		double elapsed = Now() - start;
+
+		printf(
+				"%7u  %6.2f\n",
+				numThreads,
+				numThreads * OPS_PER_THREAD / elapsed * 1e-6
+		);
+		FoxConcurrentMapFree(map);
+	}
+
+	return 0;
+}
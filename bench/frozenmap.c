@@ -0,0 +1,85 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "foxutils/frozenmap.h"
+#include "foxutils/mapmacs.h"
+#include "foxutils/xoshiro256ss.h"
+
+
+
+#define MIN_KEYS (1ul << 12)
+
+#define MAX_KEYS (1ul << 22)
+
+#define NUM_LOOKUPS (1ul << 22)
+
+
+
+static uint64_t keys[NUM_LOOKUPS];
+
+
+
+static double Now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void Run(
+		FoxXoshiro256SS * prng,
+		size_t numKeys
+) {
+	FoxMap * map = FoxMapMNew(uint64_t, uint64_t);
+	for (uint64_t key = 0; key < numKeys; key++) {
+		*FoxMapMInsert(uint64_t, uint64_t, map, key) = key;
+	}
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		keys[idx] = FoxXoshiro256SSNext(prng) % numKeys;
+	}
+
+	double start = Now();
+	FoxFrozenMap * frozen = FoxMapFreeze(map);
+	double build = (Now() - start) * 1e3;
+
+	uint64_t sum = 0;
+	start = Now();
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		sum += *(uint64_t *)FoxMapIndex(map, keys + idx);
+	}
+	double mutable = NUM_LOOKUPS / (Now() - start) * 1e-6;
+
+	start = Now();
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		sum -= *(const uint64_t *)FoxFrozenMapIndex(frozen, keys + idx);
+	}
+	double immutable = NUM_LOOKUPS / (Now() - start) * 1e-6;
+
+	printf(
+			"%8zu  %12.2f  %13.2f  %19.2f%s\n",
+			numKeys,
+			build,
+			mutable,
+			immutable,
+			(sum == 0) ? "" : "  (mismatch)"
+	);
+	FoxFrozenMapFree(frozen);
+	FoxMapFree(map);
+
+	return;
+}
+
+
+
+int main(void) {
+	FoxXoshiro256SS prng;
+	FoxXoshiro256SSInit(&prng, 0);
+
+	printf("    keys  freeze (ms)  FoxMap Mops/s  FoxFrozenMap Mops/s\n");
+	for (size_t numKeys = MIN_KEYS; numKeys <= MAX_KEYS; numKeys *= 4) {
+		Run(&prng, numKeys);
+	}
+
+	return 0;
+}
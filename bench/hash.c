@@ -0,0 +1,229 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "foxutils/hash.h"
+#include "foxutils/math.h"
+#include "foxutils/xoshiro256ss.h"
+
+
+
+#define MAX_LENGTH 4096ul
+
+#define BYTES_PER_RUN (1ul << 26)
+
+#define MIN_RUNS (1ul << 16)
+
+#define MAX_AVALANCHE_LENGTH 256ul
+
+#define NUM_AVALANCHE_TRIALS 1000
+
+/* Bias beyond this (about 6 standard deviations) fails the run. */
+#define MAX_BIAS 0.1
+
+#define NUM_SLOTS (1ul << 16)
+
+/* Standard deviation of the buckets' chi-squared statistic, sqrt(2 * slots). */
+#define CHI_SQUARED_STDDEV 362.039
+
+/* Bucket chi-squared z-scores beyond this fail the run. */
+#define MAX_Z_SCORE 6.0
+
+
+
+static char buf[MAX_LENGTH + 8];
+
+static uint32_t flips[MAX_AVALANCHE_LENGTH * 8][64];
+
+static uint32_t buckets[NUM_SLOTS];
+
+static volatile uint64_t sink;
+
+
+
+static uint64_t Cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	/* Fall back on nanoseconds. */
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec * 1000000000ull + now.tv_nsec;
+#endif
+}
+
+static void RunThroughput(size_t len) {
+	size_t numRuns = FoxMax(BYTES_PER_RUN / len, MIN_RUNS);
+	uint64_t sum = 0;
+
+	/* Vary the start of each key a little to cover unaligned keys. */
+	uint64_t start = Cycles();
+	for (size_t idx = 0; idx < numRuns; idx++) {
+		sum += FoxHashMem(buf + (idx & 0x7), len);
+	}
+	double mem = (double)len * numRuns / (Cycles() - start);
+
+	char saved = buf[len];
+	buf[len] = '\0';
+	start = Cycles();
+	for (size_t idx = 0; idx < numRuns; idx++) sum += FoxHashString(buf);
+	double str = (double)len * numRuns / (Cycles() - start);
+	buf[len] = saved;
+	sink = sum;
+
+	printf("%6zu  %15.3f  %18.3f\n", len, mem, str);
+
+	return;
+}
+
+static bool RunAvalanche(
+		FoxXoshiro256SS * prng,
+		size_t len
+) {
+	unsigned char key[MAX_AVALANCHE_LENGTH];
+	size_t numBits = len * 8;
+	memset(flips, 0, sizeof(flips[0]) * numBits);
+
+	/* Count how often flipping each key bit flips each hash bit. */
+	for (size_t trial = 0; trial < NUM_AVALANCHE_TRIALS; trial++) {
+		for (size_t idx = 0; idx < len; idx++) {
+			key[idx] = (unsigned char)FoxXoshiro256SSNext(prng);
+		}
+		uint64_t hash = FoxHashMem(key, len);
+		for (size_t bit = 0; bit < numBits; bit++) {
+			key[bit / 8] ^= 1u << (bit % 8);
+			uint64_t diff = hash ^ FoxHashMem(key, len);
+			key[bit / 8] ^= 1u << (bit % 8);
+			for (size_t out = 0; out < 64; out++) {
+				flips[bit][out] += (diff >> out) & 0x1;
+			}
+		}
+	}
+
+	double worst = 0.0;
+	double total = 0.0;
+	for (size_t bit = 0; bit < numBits; bit++) {
+		for (size_t out = 0; out < 64; out++) {
+			double prob = (double)flips[bit][out] / NUM_AVALANCHE_TRIALS;
+			worst = FoxMax(worst, FoxMax(prob - 0.5, 0.5 - prob));
+			total += prob;
+		}
+	}
+	bool pass = worst < MAX_BIAS;
+
+	printf(
+			"%6zu  %18.3f  %10.3f  %s\n",
+			len,
+			total / numBits,
+			worst,
+			(pass) ? "ok" : "FAIL"
+	);
+
+	return pass;
+}
+
+/*
+ * Distribute keys over buckets as FoxMap does (by masking hashes with
+ * slotIdxMask), then compare the bucket sizes with those of a uniformly
+ * random hash.
+ */
+static bool RunBuckets(
+		const char * name,
+		uint64_t (* keyHash)(size_t)
+) {
+	memset(buckets, 0, sizeof(buckets));
+	for (size_t idx = 0; idx < NUM_SLOTS; idx++) {
+		buckets[keyHash(idx) & (NUM_SLOTS - 1)]++;
+	}
+
+	/* There are as many keys as slots, so the expected bucket size is one. */
+	double chiSquared = 0.0;
+	uint32_t longest = 0;
+	for (size_t idx = 0; idx < NUM_SLOTS; idx++) {
+		double dev = buckets[idx] - 1.0;
+		chiSquared += dev * dev;
+		longest = FoxMax(longest, buckets[idx]);
+	}
+	double zScore = (chiSquared - NUM_SLOTS) / CHI_SQUARED_STDDEV;
+	bool pass = zScore < MAX_Z_SCORE;
+
+	printf(
+			"%-12s  %9.2f  %7u  %s\n",
+			name,
+			zScore,
+			longest,
+			(pass) ? "ok" : "FAIL"
+	);
+
+	return pass;
+}
+
+static uint64_t SequentialHash(size_t idx) {
+	uint64_t key = idx;
+
+	return FoxHashMem(&key, sizeof(key));
+}
+
+static uint64_t StridedHash(size_t idx) {
+	uint64_t key = idx << 16;
+
+	return FoxHashMem(&key, sizeof(key));
+}
+
+static uint64_t Int32Hash(size_t idx) {
+	uint32_t key = idx;
+
+	return FoxHashMem(&key, sizeof(key));
+}
+
+static uint64_t StringHash(size_t idx) {
+	char key[32];
+	snprintf(key, sizeof(key), "key-%zu", idx);
+
+	return FoxHashString(key);
+}
+
+static uint64_t LongStringHash(size_t idx) {
+	char key[80];
+	snprintf(key, sizeof(key), "/usr/share/doc/package-%zu/README", idx);
+
+	return FoxHashString(key);
+}
+
+
+
+int main(void) {
+	FoxXoshiro256SS prng;
+	FoxXoshiro256SSInit(&prng, 0);
+	for (size_t idx = 0; idx < sizeof(buf); idx++) {
+		buf[idx] = 'a' + FoxXoshiro256SSNext(&prng) % 26;
+	}
+	bool pass = true;
+
+	printf("length  Mem bytes/cycle  String bytes/cycle\n");
+	for (size_t len = 1; len <= MAX_LENGTH; len *= 2) {
+		RunThroughput(len);
+		if (len >= 4 && len < MAX_LENGTH) RunThroughput(len + len / 2);
+	}
+
+	printf("\nlength  Mean flipped bits  Worst bias\n");
+	size_t lengths[] = {2, 4, 8, 13, 32, 64, 100, 256};
+	for (size_t idx = 0; idx < sizeof(lengths) / sizeof(lengths[0]); idx++) {
+		pass &= RunAvalanche(&prng, lengths[idx]);
+	}
+
+	printf("\nkeys          Bucket z  Longest\n");
+	pass &= RunBuckets("sequential", &SequentialHash);
+	pass &= RunBuckets("strided", &StridedHash);
+	pass &= RunBuckets("int32", &Int32Hash);
+	pass &= RunBuckets("string", &StringHash);
+	pass &= RunBuckets("long string", &LongStringHash);
+
+	return (pass) ? 0 : 1;
+}
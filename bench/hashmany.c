@@ -0,0 +1,111 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "foxutils/hash.h"
+#include "foxutils/xoshiro256ss.h"
+
+
+
+#define NUM_KEYS (1ul << 14)
+
+#define NUM_ROUNDS 2000
+
+
+
+static uint64_t keys64[NUM_KEYS];
+
+static uint32_t keys32[NUM_KEYS];
+
+static uint64_t hashes[NUM_KEYS];
+
+
+
+static double Now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static uint64_t Checksum(void) {
+	uint64_t sum = 0;
+	for (size_t idx = 0; idx < NUM_KEYS; idx++) sum += hashes[idx];
+
+	return sum;
+}
+
+static void Report(
+		const char * name,
+		size_t keySize,
+		double single,
+		double many
+) {
+	double bytes = (double)NUM_KEYS * NUM_ROUNDS * keySize * 1e-9;
+	printf(
+			"%-4s  %13.2f  %11.2f  %7.2fx\n",
+			name,
+			bytes / single,
+			bytes / many,
+			single / many
+	);
+
+	return;
+}
+
+static int RunU64(void) {
+	double start = Now();
+	for (size_t round = 0; round < NUM_ROUNDS; round++) {
+		for (size_t idx = 0; idx < NUM_KEYS; idx++) {
+			hashes[idx] = FoxHashULongLong(keys64[idx]);
+		}
+	}
+	double single = Now() - start;
+	uint64_t sum = Checksum();
+
+	start = Now();
+	for (size_t round = 0; round < NUM_ROUNDS; round++) {
+		FoxHashU64Many(keys64, NUM_KEYS, hashes);
+	}
+	double many = Now() - start;
+
+	Report("u64", sizeof(uint64_t), single, many);
+
+	return (Checksum() == sum) ? 0 : 1;
+}
+
+static int RunU32(void) {
+	double start = Now();
+	for (size_t round = 0; round < NUM_ROUNDS; round++) {
+		for (size_t idx = 0; idx < NUM_KEYS; idx++) {
+			hashes[idx] = FoxHashUInt(keys32[idx]);
+		}
+	}
+	double single = Now() - start;
+	uint64_t sum = Checksum();
+
+	start = Now();
+	for (size_t round = 0; round < NUM_ROUNDS; round++) {
+		FoxHashU32Many(keys32, NUM_KEYS, hashes);
+	}
+	double many = Now() - start;
+
+	Report("u32", sizeof(uint32_t), single, many);
+
+	return (Checksum() == sum) ? 0 : 1;
+}
+
+
+
+int main(void) {
+	FoxXoshiro256SS prng;
+	FoxXoshiro256SSInit(&prng, 0);
+	for (size_t idx = 0; idx < NUM_KEYS; idx++) {
+		keys64[idx] = FoxXoshiro256SSNext(&prng);
+		keys32[idx] = (uint32_t)keys64[idx];
+	}
+
+	printf("keys  Single (GB/s)  Many (GB/s)  Speedup\n");
+
+	return RunU64() | RunU32();
+}
@@ -0,0 +1,186 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "foxutils/flatmap.h"
+#include "foxutils/map.h"
+#include "foxutils/math.h"
+#include "foxutils/xoshiro256ss.h"
+
+
+
+#define MIN_KEYS (1ul << 12)
+
+#define MAX_KEYS (1ul << 24)
+
+#define NUM_LOOKUPS (1ul << 22)
+
+#define BATCH_SIZE 4096ul
+
+
+
+static uint64_t keys[NUM_LOOKUPS];
+
+static uint64_t misses[NUM_LOOKUPS];
+
+static void * elems[BATCH_SIZE];
+
+
+
+static double Now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void Print(
+		size_t numKeys,
+		const char * name,
+		double insert,
+		double hit,
+		double miss,
+		double batched,
+		bool match
+) {
+	printf(
+			"%8zu  %-10s  %13.2f  %10.2f  %11.2f",
+			numKeys,
+			name,
+			insert,
+			hit,
+			miss
+	);
+	if (batched > 0.0) {
+		printf("  %16.2f", batched);
+	} else {
+		printf("  %16s", "-");
+	}
+	printf("%s\n", (match) ? "" : "  (mismatch)");
+
+	return;
+}
+
+static void Run(
+		size_t numKeys,
+		bool robinHood
+) {
+	FoxMap * map = FoxMapNew(
+			sizeof(uint64_t),
+			sizeof(uint64_t),
+			numKeys,
+			FOXMAP_DEF_GROWRATE,
+			FOXMAP_DEF_LFTHRESH,
+			NULL,
+			NULL,
+			NULL,
+			NULL
+	);
+	FoxMapSetRobinHood(map, robinHood);
+	double start = Now();
+	for (uint64_t key = 0; key < numKeys; key++) {
+		*(uint64_t *)FoxMapInsert(map, &key) = key;
+	}
+	double insert = numKeys / (Now() - start) * 1e-6;
+
+	uint64_t sum = 0;
+	start = Now();
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		sum += *(uint64_t *)FoxMapIndex(map, keys + idx);
+	}
+	double hit = NUM_LOOKUPS / (Now() - start) * 1e-6;
+
+	size_t numFound = 0;
+	start = Now();
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		numFound += FoxMapIndex(map, misses + idx) != NULL;
+	}
+	double miss = NUM_LOOKUPS / (Now() - start) * 1e-6;
+
+	start = Now();
+	for (size_t batchIdx = 0; batchIdx < NUM_LOOKUPS; batchIdx += BATCH_SIZE) {
+		FoxMapIndexMany(map, keys + batchIdx, BATCH_SIZE, elems);
+		for (size_t idx = 0; idx < BATCH_SIZE; idx++) {
+			sum -= *(uint64_t *)elems[idx];
+		}
+	}
+	double batched = NUM_LOOKUPS / (Now() - start) * 1e-6;
+
+	Print(
+			numKeys,
+			(robinHood) ? "robin hood" : "chaining",
+			insert,
+			hit,
+			miss,
+			batched,
+			sum == 0 && numFound == 0
+	);
+	FoxMapFree(map);
+
+	return;
+}
+
+static void RunFlat(size_t numKeys) {
+	FoxFlatMap * map = FoxFlatMapNew(
+			sizeof(uint64_t),
+			sizeof(uint64_t),
+			numKeys,
+			NULL,
+			NULL,
+			NULL,
+			NULL
+	);
+	double start = Now();
+	for (uint64_t key = 0; key < numKeys; key++) {
+		*(uint64_t *)FoxFlatMapInsert(map, &key) = key;
+	}
+	double insert = numKeys / (Now() - start) * 1e-6;
+
+	uint64_t sum = 0;
+	start = Now();
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		sum += *(uint64_t *)FoxFlatMapIndex(map, keys + idx);
+	}
+	double hit = NUM_LOOKUPS / (Now() - start) * 1e-6;
+
+	size_t numFound = 0;
+	start = Now();
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		numFound += FoxFlatMapIndex(map, misses + idx) != NULL;
+	}
+	double miss = NUM_LOOKUPS / (Now() - start) * 1e-6;
+
+	/* There is no batched lookup, so check the hits' sum directly. */
+	uint64_t expected = 0;
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) expected += keys[idx];
+	Print(numKeys, "flat", insert, hit, miss, 0.0, sum == expected);
+	FoxFlatMapFree(map);
+
+	return;
+}
+
+
+
+int main(void) {
+	FoxXoshiro256SS prng;
+	FoxXoshiro256SSInit(&prng, 0);
+
+	printf(
+			"    keys  map         Insert Mops/s  Hit Mops/s  Miss Mops/s"
+			"  IndexMany Mops/s\n"
+	);
+	for (size_t numKeys = MIN_KEYS; numKeys <= MAX_KEYS; numKeys *= 4) {
+		/* Every map is probed with the same hits and misses. */
+		for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+			keys[idx] = FoxXoshiro256SSNext(&prng) % numKeys;
+			misses[idx] = numKeys + FoxXoshiro256SSNext(&prng) % numKeys;
+		}
+		Run(numKeys, false);
+		Run(numKeys, true);
+		RunFlat(numKeys);
+	}
+
+	return 0;
+}
@@ -0,0 +1,79 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "foxutils/mappedmap.h"
+#include "foxutils/stringmap.h"
+#include "foxutils/xoshiro256ss.h"
+
+
+
+#define NUM_KEYS (1ul << 20)
+
+#define NUM_LOOKUPS (1ul << 22)
+
+#define FILE_PATH "/tmp/foxutils-bench-mappedmap.map"
+
+
+
+static char keys[NUM_KEYS][24];
+
+static const char * lookups[NUM_LOOKUPS];
+
+
+
+static double Now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+
+
+int main(void) {
+	FoxXoshiro256SS prng;
+	FoxXoshiro256SSInit(&prng, 0);
+	for (size_t idx = 0; idx < NUM_KEYS; idx++) {
+		snprintf(keys[idx], sizeof(keys[idx]), "key-%zu", idx);
+	}
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		lookups[idx] = keys[FoxXoshiro256SSNext(&prng) % NUM_KEYS];
+	}
+
+	double start = Now();
+	FoxMap * map = FoxStringMapNew(sizeof(uint64_t), 16, 2.0f, 1.0f);
+	for (uint64_t idx = 0; idx < NUM_KEYS; idx++) {
+		*(uint64_t *)FoxMapInsert(map, &(const char *){keys[idx]}) = idx;
+	}
+	double build = (Now() - start) * 1e3;
+	if (!FoxStringMapSave(map, FILE_PATH)) return 1;
+
+	start = Now();
+	FoxMappedMap * mapped = FoxMapOpenMapped(FILE_PATH);
+	double open = (Now() - start) * 1e3;
+	if (!mapped) return 1;
+
+	uint64_t sum = 0;
+	start = Now();
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		sum += *(uint64_t *)FoxMapIndex(map, lookups + idx);
+	}
+	double heap = NUM_LOOKUPS / (Now() - start) * 1e-6;
+
+	start = Now();
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		sum -= *(const uint64_t *)FoxMappedMapIndex(mapped, lookups + idx);
+	}
+	double file = NUM_LOOKUPS / (Now() - start) * 1e-6;
+
+	printf("               startup (ms)  Index Mops/s\n");
+	printf("FoxMap:        %12.2f  %12.2f\n", build, heap);
+	printf("FoxMappedMap:  %12.2f  %12.2f\n", open, file);
+
+	FoxMappedMapFree(mapped);
+	FoxMapFree(map);
+	remove(FILE_PATH);
+
+	return (sum == 0) ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "foxutils/rand.h"
+#include "foxutils/splitmix64.h"
+#include "foxutils/xorshift64.h"
+#include "foxutils/xoshiro256ss.h"
+
+
+
+#define NUM_VALUES (1ul << 12)
+
+#define NUM_ROUNDS 20000
+
+
+
+static uint64_t values[NUM_VALUES];
+
+static double doubles[NUM_VALUES];
+
+
+
+static double Now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static double Rate(double start) {
+	return (double)NUM_VALUES * NUM_ROUNDS / (Now() - start) * 1e-6;
+}
+
+static void Run(
+		const char * name,
+		FoxPRNG * prng
+) {
+	double start = Now();
+	for (size_t round = 0; round < NUM_ROUNDS; round++) {
+		for (size_t idx = 0; idx < NUM_VALUES; idx++) {
+			values[idx] = FoxRandUInt(prng);
+		}
+	}
+	double next = Rate(start);
+
+	start = Now();
+	for (size_t round = 0; round < NUM_ROUNDS; round++) {
+		FoxRandFillU64(prng, values, NUM_VALUES);
+	}
+	double fill = Rate(start);
+
+	start = Now();
+	for (size_t round = 0; round < NUM_ROUNDS; round++) {
+		for (size_t idx = 0; idx < NUM_VALUES; idx++) {
+			doubles[idx] = FoxRandDouble(prng);
+		}
+	}
+	double nextDouble = Rate(start);
+
+	start = Now();
+	for (size_t round = 0; round < NUM_ROUNDS; round++) {
+		FoxRandFillDouble(prng, doubles, NUM_VALUES);
+	}
+	double fillDouble = Rate(start);
+
+	printf(
+			"%-12s  %10.0f  %10.0f  %12.0f  %16.0f\n",
+			name,
+			next,
+			fill,
+			nextDouble,
+			fillDouble
+	);
+
+	return;
+}
+
+
+
+int main(void) {
+	FoxXoshiro256SS xoshiro;
+	FoxXoshiro256SSInit(&xoshiro, 0);
+	FoxSplitMix64 splitMix;
+	FoxSplitMix64Init(&splitMix, 0);
+	FoxXorshift64 xorshift;
+	FoxXorshift64Init(&xorshift, 0);
+
+	printf(
+			"generator     UInt Mop/s  Fill Mop/s  Double Mop/s  "
+			"FillDouble Mop/s\n"
+	);
+	Run("xoshiro256**", &xoshiro.super);
+	Run("splitmix64", &splitMix.super);
+	Run("xorshift64", &xorshift.super);
+
+	return 0;
+}
@@ -0,0 +1,186 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "foxutils/concurrentmap.h"
+#include "foxutils/rcumap.h"
+#include "foxutils/xoshiro256ss.h"
+
+
+
+#define NUM_KEYS (1ul << 16)
+
+#define OPS_PER_THREAD (1ul << 22)
+
+#define OPS_PER_QUIESCENT 64ul
+
+#define MAX_THREADS 64u
+
+
+
+typedef struct Worker {
+	pthread_t thread;
+	FoxRcuMap * rcuMap;
+	FoxConcurrentMap * concMap;
+	uint64_t seed;
+	uint64_t sum;
+} Worker;
+
+
+
+static atomic_bool stopWriter;
+
+
+
+/* Lookups only, announcing a quiescent state every so often. */
+static void * RcuRead(Worker * worker) {
+	FoxRcuMap * map = worker->rcuMap;
+	FoxRcuMapReader * reader = FoxRcuMapRegisterReader(map);
+	FoxXoshiro256SS prng;
+	FoxXoshiro256SSInit(&prng, worker->seed);
+
+	uint64_t sum = 0;
+	for (unsigned long op = 0; op < OPS_PER_THREAD; op++) {
+		uint64_t key = FoxXoshiro256SSNext(&prng) % NUM_KEYS;
+		const uint64_t * elem = FoxRcuMapIndex(map, &key);
+		if (elem) sum += *elem;
+		if (op % OPS_PER_QUIESCENT == 0) FoxRcuMapQuiescent(map, reader);
+	}
+	worker->sum = sum;
+
+	FoxRcuMapUnregisterReader(map, reader);
+
+	return NULL;
+}
+
+static void * ConcRead(Worker * worker) {
+	FoxConcurrentMap * map = worker->concMap;
+	FoxXoshiro256SS prng;
+	FoxXoshiro256SSInit(&prng, worker->seed);
+
+	uint64_t sum = 0;
+	for (unsigned long op = 0; op < OPS_PER_THREAD; op++) {
+		uint64_t key = FoxXoshiro256SSNext(&prng) % NUM_KEYS;
+		uint64_t elem;
+		if (FoxConcurrentMapIndex(map, &key, &elem)) sum += elem;
+	}
+	worker->sum = sum;
+
+	return NULL;
+}
+
+/* Slow trickle of replacements so that reclamation has work to do. */
+static void * RcuWrite(Worker * worker) {
+	FoxRcuMap * map = worker->rcuMap;
+	FoxXoshiro256SS prng;
+	FoxXoshiro256SSInit(&prng, worker->seed);
+
+	while (!atomic_load(&stopWriter)) {
+		uint64_t key = FoxXoshiro256SSNext(&prng) % NUM_KEYS;
+		FoxRcuMapInsert(map, &key, &key);
+		struct timespec pause = {.tv_nsec = 100000};
+		nanosleep(&pause, NULL);
+	}
+
+	return NULL;
+}
+
+static double Now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static double Run(
+		Worker * workers,
+		unsigned int numThreads,
+		void * (* work)(Worker *)
+) {
+	double start = Now();
+	for (unsigned int idx = 0; idx < numThreads; idx++) {
+		pthread_create(
+				&workers[idx].thread,
+				NULL,
+				(void * (*)(void *))work,
+				&workers[idx]
+		);
+	}
+	for (unsigned int idx = 0; idx < numThreads; idx++) {
+		pthread_join(workers[idx].thread, NULL);
+	}
+
+	return numThreads * OPS_PER_THREAD / (Now() - start) * 1e-6;
+}
+
+
+
+int main(void) {
+	static Worker workers[MAX_THREADS];
+
+	FoxRcuMap * rcuMap = FoxRcuMapNew(
+			sizeof(uint64_t),
+			sizeof(uint64_t),
+			NUM_KEYS,
+			FOXRCUMAP_DEF_GROWRATE,
+			FOXRCUMAP_DEF_LFTHRESH,
+			NULL,
+			NULL,
+			NULL,
+			NULL
+	);
+	FoxConcurrentMap * concMap = FoxConcurrentMapNew(
+			sizeof(uint64_t),
+			sizeof(uint64_t),
+			FOXCONCURRENTMAP_DEF_NUMSHARDS,
+			NUM_KEYS,
+			FOXMAP_DEF_GROWRATE,
+			FOXMAP_DEF_LFTHRESH,
+			NULL,
+			NULL,
+			NULL,
+			NULL
+	);
+	for (uint64_t key = 0; key < NUM_KEYS; key++) {
+		FoxRcuMapInsert(rcuMap, &key, &key);
+		FoxConcurrentMapInsert(concMap, &key, &key);
+	}
+
+	printf("threads  rcumap Mops/s  concurrentmap Mops/s\n");
+	for (
+			unsigned int numThreads = 1;
+			numThreads <= MAX_THREADS;
+			numThreads *= 2
+	) {
+		for (unsigned int idx = 0; idx < numThreads; idx++) {
+			workers[idx] = (Worker){
+				.rcuMap = rcuMap,
+				.concMap = concMap,
+				.seed = idx
+			};
+		}
+
+		Worker writer = {.rcuMap = rcuMap, .seed = UINT64_MAX};
+		atomic_store(&stopWriter, false);
+		pthread_create(
+				&writer.thread,
+				NULL,
+				(void * (*)(void *))&RcuWrite,
+				&writer
+		);
+		double rcuRate = Run(workers, numThreads, &RcuRead);
+		atomic_store(&stopWriter, true);
+		pthread_join(writer.thread, NULL);
+
+		double concRate = Run(workers, numThreads, &ConcRead);
+
+		printf("%7u  %13.2f  %20.2f\n", numThreads, rcuRate, concRate);
+	}
+
+	FoxConcurrentMapFree(concMap);
+	FoxRcuMapFree(rcuMap);
+
+	return 0;
+}
@@ -0,0 +1,84 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "foxutils/stringmap.h"
+#include "foxutils/xoshiro256ss.h"
+
+
+
+#define NUM_KEYS (1ul << 22)
+
+#define NUM_LOOKUPS (1ul << 22)
+
+
+
+static char keys[NUM_KEYS][24];
+
+static const char * lookups[NUM_LOOKUPS];
+
+
+
+static double Now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static uint64_t Run(
+		bool arena,
+		bool keyed
+) {
+	double start = Now();
+	FoxMap * map = FoxStringMapNew(sizeof(uint64_t), 16, 2.0f, 1.0f);
+	if (arena) FoxStringMapUseArena(map);
+	FoxMapSetKeyedHash(map, keyed);
+	for (uint64_t idx = 0; idx < NUM_KEYS; idx++) {
+		*(uint64_t *)FoxMapInsert(map, &(const char *){keys[idx]}) = idx;
+	}
+	double insert = NUM_KEYS / (Now() - start) * 1e-6;
+
+	uint64_t sum = 0;
+	start = Now();
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		sum += *(uint64_t *)FoxMapIndex(map, lookups + idx);
+	}
+	double index = NUM_LOOKUPS / (Now() - start) * 1e-6;
+
+	start = Now();
+	FoxMapFree(map);
+	double teardown = (Now() - start) * 1e3;
+
+	printf(
+			"%-7s  %-7s  %13.2f  %12.2f  %9.2f\n",
+			(arena) ? "arena" : "malloc",
+			(keyed) ? "keyed" : "seeded",
+			insert,
+			index,
+			teardown
+	);
+
+	return sum;
+}
+
+
+
+int main(void) {
+	FoxXoshiro256SS prng;
+	FoxXoshiro256SSInit(&prng, 0);
+	for (size_t idx = 0; idx < NUM_KEYS; idx++) {
+		snprintf(keys[idx], sizeof(keys[idx]), "key-%zu", idx);
+	}
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		lookups[idx] = keys[FoxXoshiro256SSNext(&prng) % NUM_KEYS];
+	}
+
+	printf("keys     hashing  Insert Mops/s  Index Mops/s  Free (ms)\n");
+	uint64_t sum = Run(false, true);
+	bool pass = Run(true, true) == sum;
+	pass &= Run(true, false) == sum;
+
+	return (pass) ? 0 : 1;
+}
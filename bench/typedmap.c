@@ -0,0 +1,83 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "foxutils/mapmacs.h"
+#include "foxutils/xoshiro256ss.h"
+
+
+
+#define NUM_KEYS (1ul << 16)
+
+#define NUM_LOOKUPS (1ul << 24)
+
+
+
+typedef struct Record {
+	uint64_t id;
+	double value;
+	uint32_t flags;
+} Record;
+
+static inline uint64_t HashU64(uint64_t key) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+
+	return key;
+}
+
+#define EqualU64(keyA, keyB) ((keyA) == (keyB))
+
+FOXMAP_DEFINE(RecordMap, uint64_t, Record, HashU64, EqualU64)
+
+
+
+static uint64_t keys[NUM_LOOKUPS];
+
+
+
+static double Now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+
+
+int main(void) {
+	FoxXoshiro256SS prng;
+	FoxXoshiro256SSInit(&prng, 0);
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		keys[idx] = FoxXoshiro256SSNext(&prng) % NUM_KEYS;
+	}
+
+	FoxMap * map = FoxMapMNew(uint64_t, Record);
+	RecordMap * typedMap = RecordMapNew();
+	for (uint64_t key = 0; key < NUM_KEYS; key++) {
+		*FoxMapMInsert(uint64_t, Record, map, key) = (Record){.id = key};
+		*RecordMapInsert(typedMap, key) = (Record){.id = key};
+	}
+
+	uint64_t sum = 0;
+	double start = Now();
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		sum += FoxMapMIndex(uint64_t, Record, map, keys[idx])->id;
+	}
+	double generic = NUM_LOOKUPS / (Now() - start) * 1e-6;
+
+	start = Now();
+	for (size_t idx = 0; idx < NUM_LOOKUPS; idx++) {
+		sum -= RecordMapIndex(typedMap, keys[idx])->id;
+	}
+	double typed = NUM_LOOKUPS / (Now() - start) * 1e-6;
+
+	printf("FoxMap:        %8.2f Mops/s\n", generic);
+	printf("FOXMAP_DEFINE: %8.2f Mops/s\n", typed);
+
+	RecordMapFree(typedMap);
+	FoxMapFree(map);
+
+	return (sum == 0) ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2020 Garrett Russell Fairburn
+ * 
+ * @copyright This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ *
+ * @brief Chunked arena (or "bump") allocator.
+ *
+ * Allocations are carved out of large chunks and cannot be freed
+ * individually. Instead, all of them are freed at once when the arena is
+ * de-initialized.
+ */
+#ifndef FOXUTILS_ARENA_H
+#define FOXUTILS_ARENA_H
+
+#include <stddef.h>
+
+
+
+/* ----- PUBLIC MACROS ----- */
+
+/**
+ * Arena default chunk size (in bytes).
+ */
+#define FOXARENA_DEF_CHUNKSIZE 65536ul
+
+
+
+/* ----- PUBLIC TYPES ----- */
+
+/**
+ * @brief Arena allocator data structure.
+ *
+ * @note While it is possible to directly access this struct's members, using
+ * the functions provided by the foxutils/arena.h module is preferred.
+ */
+typedef struct FoxArena {
+	struct FoxArenaChunk * chunks; /**< Most recently allocated chunk (which
+																		links to the chunk before it). */
+	unsigned char * next; /**< Next free byte of current chunk. */
+	size_t avail; /**< Number of free bytes left in current chunk. */
+	size_t chunkSize; /**< Size (in bytes) of each chunk. */
+} FoxArena;
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+FoxArena * FoxArenaNew(size_t chunkSize);
+
+void FoxArenaFree(FoxArena * arena);
+
+void FoxArenaInit(
+		FoxArena * arena,
+		size_t chunkSize
+);
+
+void FoxArenaDeinit(FoxArena * arena);
+
+/**
+ * Allocate memory from an arena.
+ *
+ * Allocations larger than a quarter of the chunk size get a chunk of their
+ * own, so they never waste the rest of the current chunk.
+ *
+ * @param[in] align Alignment (a power of two no greater than that of
+ * max_align_t).
+ *
+ * @return Memory which remains valid until the arena is de-initialized.
+ */
+void * FoxArenaAlloc(
+		FoxArena * arena,
+		size_t size,
+		size_t align
+);
+
+
+
+#endif /* FOXUTILS_ARENA_H */
@@ -150,6 +150,16 @@ void FoxArrayEnsureCapacity(
 		size_t cap
 );
 
+/**
+ * Release any unused capacity of a dynamic array.
+ *
+ * The capacity of the dynamic array will be reduced to its size (or 1 if it
+ * is empty).
+ *
+ * @param[in] array Array to shrink.
+ */
+void FoxArrayShrink(FoxArray * array);
+
 /**
  * Get an element in a dynamic array.
  *
@@ -160,7 +170,7 @@ void FoxArrayEnsureCapacity(
  */
 void * FoxArrayIndex(
 		FoxArray * array,
-		unsigned int idx
+		size_t idx
 );
 
 /**
@@ -187,7 +197,7 @@ void * FoxArrayPeek(FoxArray * array);
  */
 void * FoxArrayInsert(
 		FoxArray * array,
-		unsigned int idx
+		size_t idx
 );
 
 /**
@@ -209,7 +219,7 @@ void * FoxArrayPush(FoxArray * array);
  */
 void FoxArrayRemove(
 		FoxArray * array,
-		unsigned int idx,
+		size_t idx,
 		void * elem
 );
 
@@ -50,6 +50,9 @@
 #define FoxArrayMEnsureCapacity(T, array, cap) \
 	FoxArrayEnsureCapacity((array), (cap))
 
+#define FoxArrayMShrink(T, array) \
+	FoxArrayShrink((array))
+
 #define FoxArrayMIndex(T, array, idx) \
 	((T *)FoxArrayIndex((array), (idx)))
 
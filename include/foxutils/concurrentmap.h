@@ -0,0 +1,167 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2020 Garrett Russell Fairburn
+ * 
+ * @copyright This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ *
+ * @brief Thread-safe, lock-striped wrapper around foxutils/map.h.
+ *
+ * Keys are distributed across a fixed number of independent shards by the
+ * high bits of their hashes, and each shard is a FoxMap guarded by its own
+ * reader/writer lock. Because other threads may move elements at any time,
+ * elements are copied into and out of the map rather than being referenced
+ * in place.
+ */
+#ifndef FOXUTILS_CONCURRENTMAP_H
+#define FOXUTILS_CONCURRENTMAP_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "foxutils/map.h"
+
+
+
+/* ----- PUBLIC MACROS ----- */
+
+#define FOXCONCURRENTMAP_DEF_NUMSHARDS 64ul
+
+
+
+/* ----- PUBLIC TYPES ----- */
+
+/**
+ * @brief Single lock-guarded shard of a concurrent hash table.
+ */
+typedef struct FoxConcurrentMapShard {
+	_Alignas(64) pthread_rwlock_t lock; /**< Shard reader/writer lock. */
+	FoxMap map; /**< Shard hash table. */
+} FoxConcurrentMapShard;
+
+/**
+ * @brief Concurrent hash table data structure.
+ *
+ * @note While it is possible to directly access this struct's members, using
+ * the functions provided by the foxutils/concurrentmap.h module is preferred.
+ */
+typedef struct FoxConcurrentMap {
+	FoxConcurrentMapShard * shards; /**< Map shards. */
+	size_t numShards; /**< Number of shards (always a power of 2). */
+	unsigned int shardShift; /**< Right shift applied to the upper half of
+														remixed hashes to generate a shard index. */
+	size_t elemSize; /**< Size (in bytes) of each map element. */
+} FoxConcurrentMap;
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+FoxConcurrentMap * FoxConcurrentMapNew(
+		size_t keySize,
+		size_t elemSize,
+		size_t numShards,
+		size_t initSlots,
+		float growRate,
+		float lfThresh,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void * copy, const void * key),
+		void (* keyDeinit)(void * key)
+);
+
+void FoxConcurrentMapFree(FoxConcurrentMap * map);
+
+void FoxConcurrentMapInit(
+		FoxConcurrentMap * map,
+		size_t keySize,
+		size_t elemSize,
+		size_t numShards,
+		size_t initSlots,
+		float growRate,
+		float lfThresh,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void * copy, const void * key),
+		void (* keyDeinit)(void * key)
+);
+
+void FoxConcurrentMapDeinit(FoxConcurrentMap * map);
+
+size_t FoxConcurrentMapSize(FoxConcurrentMap * map);
+
+/**
+ * Copy the element associated with a key (if any) into elem.
+ *
+ * @return Whether or not the key was present.
+ */
+bool FoxConcurrentMapIndex(
+		FoxConcurrentMap * map,
+		const void * key,
+		void * elem
+);
+
+/**
+ * Associate a copy of elem with a key unless the key is already present.
+ *
+ * @return Whether or not the key was inserted.
+ */
+bool FoxConcurrentMapInsert(
+		FoxConcurrentMap * map,
+		const void * key,
+		const void * elem
+);
+
+/**
+ * Run a callback on the element associated with a key while holding the
+ * key's shard lock, first inserting a zero-initialized element if the key is
+ * not already present.
+ */
+void FoxConcurrentMapUpsert(
+		FoxConcurrentMap * map,
+		const void * key,
+		void (* callback)(void * elem, bool inserted, void * ctx),
+		void * ctx
+);
+
+/**
+ * Remove a key (if present), copying its element into elem (can be NULL).
+ *
+ * @return Whether or not the key was present.
+ */
+bool FoxConcurrentMapRemove(
+		FoxConcurrentMap * map,
+		const void * key,
+		void * elem
+);
+
+/**
+ * Visit every key-element pair, one shard at a time.
+ *
+ * @note The callback runs while holding the lock of the shard being visited,
+ * so it must not call back into the map.
+ */
+void FoxConcurrentMapForEachPair(
+		FoxConcurrentMap * map,
+		bool (* callback)(const void * key, void * elem, void * ctx),
+		void * ctx
+);
+
+void FoxConcurrentMapForEachElement(
+		FoxConcurrentMap * map,
+		bool (* callback)(void * elem, void * ctx),
+		void * ctx
+);
+
+void FoxConcurrentMapForEachKey(
+		FoxConcurrentMap * map,
+		bool (* callback)(const void * key, void * ctx),
+		void * ctx
+);
+
+
+
+#endif /* FOXUTILS_CONCURRENTMAP_H */
@@ -0,0 +1,131 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2020 Garrett Russell Fairburn
+ * 
+ * @copyright This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ *
+ * @brief Flat (open addressing) hash table implementation.
+ *
+ * Unlike foxutils/map.h, this hash table stores keys and elements inline in a
+ * single contiguous slot array. Slots are probed in groups of
+ * ::FOXFLATMAP_GROUP_WIDTH using a parallel array of control bytes, each of
+ * which holds a 7-bit fingerprint of the hash of the key in its slot. The
+ * trade-off is that its load factor can never exceed 7/8.
+ */
+#ifndef FOXUTILS_FLATMAP_H
+#define FOXUTILS_FLATMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+
+/* ----- PUBLIC MACROS ----- */
+
+#define FOXFLATMAP_GROUP_WIDTH 16ul
+
+#define FOXFLATMAP_DEF_INITSLOTS 16ul
+
+
+
+/* ----- PUBLIC TYPES ----- */
+
+/**
+ * @brief Flat hash table data structure.
+ *
+ * @note While it is possible to directly access this struct's members, using
+ * the functions provided by the foxutils/flatmap.h module is preferred.
+ */
+typedef struct FoxFlatMap {
+	unsigned char * ctrl; /**< Slot control bytes (followed by slots). */
+	unsigned char * slots; /**< Map slots which wrap keys and elements. */
+	uint64_t (* keyHash)(const void *); /**< Key hashing function. */
+	int (* keyCompare)(const void *, const void *); /**< Key comparison
+																										function. */
+	void (* keyCopy)(void *, const void *); /**< Key duplication function. */
+	void (* keyDeinit)(void *); /**< Key de-initialization function. */
+	size_t keySize; /**< Size (in bytes) of each map key. */
+	size_t elemSize; /**< Size (in bytes) of each map element. */
+	size_t elemOffset; /**< Offset (in bytes) of element within slot. */
+	size_t slotSize; /**< Size (in bytes) of each map slot. */
+	size_t numSlots; /**< Total number of slots. */
+	size_t size; /**< Number of occupied slots. */
+	size_t growthLeft; /**< Number of empty slots which can be filled before
+												the map must grow. */
+} FoxFlatMap;
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+FoxFlatMap * FoxFlatMapNew(
+		size_t keySize,
+		size_t elemSize,
+		size_t initSlots,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void * copy, const void * key),
+		void (* keyDeinit)(void * key)
+);
+
+void FoxFlatMapFree(FoxFlatMap * map);
+
+void FoxFlatMapInit(
+		FoxFlatMap * map,
+		size_t keySize,
+		size_t elemSize,
+		size_t initSlots,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void * copy, const void * key),
+		void (* keyDeinit)(void * key)
+);
+
+void FoxFlatMapDeinit(FoxFlatMap * map);
+
+size_t FoxFlatMapSize(FoxFlatMap * map);
+
+bool FoxFlatMapEmpty(FoxFlatMap * map);
+
+float FoxFlatMapLoadFactor(FoxFlatMap * map);
+
+void * FoxFlatMapIndex(
+		FoxFlatMap * map,
+		const void * key
+);
+
+void * FoxFlatMapInsert(
+		FoxFlatMap * map,
+		const void * key
+);
+
+void FoxFlatMapRemove(
+		FoxFlatMap * map,
+		const void * key,
+		void * elem
+);
+
+void FoxFlatMapForEachPair(
+		FoxFlatMap * map,
+		bool (* callback)(const void * key, void * elem, void * ctx),
+		void * ctx
+);
+
+void FoxFlatMapForEachElement(
+		FoxFlatMap * map,
+		bool (* callback)(void * elem, void * ctx),
+		void * ctx
+);
+
+void FoxFlatMapForEachKey(
+		FoxFlatMap * map,
+		bool (* callback)(const void * key, void * ctx),
+		void * ctx
+);
+
+
+
+#endif /* FOXUTILS_FLATMAP_H */
@@ -0,0 +1,188 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2020 Garrett Russell Fairburn
+ * 
+ * @copyright This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ *
+ * @brief Convenience, function-like macros for foxutils/flatmap.h.
+ */
+#ifndef FOXUTILS_FLATMAPMACS_H
+#define FOXUTILS_FLATMAPMACS_H
+
+#include "foxutils/flatmap.h"
+
+
+
+/* ----- PUBLIC MACROS ----- */
+
+#define FoxFlatMapMNew( \
+		K, \
+		E \
+) \
+	FoxFlatMapNew( \
+			sizeof(K), \
+			sizeof(E), \
+			FOXFLATMAP_DEF_INITSLOTS, \
+			NULL, \
+			NULL, \
+			NULL, \
+			NULL \
+	)
+
+#define FoxFlatMapMNewExt( \
+		K, \
+		E, \
+		initSlots, \
+		keyHash, \
+		keyCompare \
+) \
+	FoxFlatMapNew( \
+			sizeof(K), \
+			sizeof(E), \
+			(initSlots), \
+			(uint64_t (*)(const void *))(keyHash), \
+			(int (*)(const void *, const void *))(keyCompare), \
+			NULL, \
+			NULL \
+	)
+
+#define FoxFlatMapMNewAdv( \
+		K, \
+		E, \
+		initSlots, \
+		keyHash, \
+		keyCompare, \
+		keyCopy, \
+		keyDeinit \
+) \
+	FoxFlatMapNew( \
+			sizeof(K), \
+			sizeof(E), \
+			(initSlots), \
+			(uint64_t (*)(const void *))(keyHash), \
+			(int (*)(const void *, const void *))(keyCompare), \
+			(void (*)(void *, const void *))(keyCopy), \
+			(void (*)(void *))(keyDeinit) \
+	)
+
+#define FoxFlatMapMFree(K, E, map) \
+	FoxFlatMapFree((map))
+
+#define FoxFlatMapMInit( \
+		K, \
+		E, \
+		map \
+) \
+	FoxFlatMapInit( \
+			(map), \
+			sizeof(K), \
+			sizeof(E), \
+			FOXFLATMAP_DEF_INITSLOTS, \
+			NULL, \
+			NULL, \
+			NULL, \
+			NULL \
+	)
+
+#define FoxFlatMapMInitExt( \
+		K, \
+		E, \
+		map, \
+		initSlots, \
+		keyHash, \
+		keyCompare \
+) \
+	FoxFlatMapInit( \
+			(map), \
+			sizeof(K), \
+			sizeof(E), \
+			(initSlots), \
+			(uint64_t (*)(const void *))(keyHash), \
+			(int (*)(const void *, const void *))(keyCompare), \
+			NULL, \
+			NULL \
+	)
+
+#define FoxFlatMapMInitAdv( \
+		K, \
+		E, \
+		map, \
+		initSlots, \
+		keyHash, \
+		keyCompare, \
+		keyCopy, \
+		keyDeinit \
+) \
+	FoxFlatMapInit( \
+			(map), \
+			sizeof(K), \
+			sizeof(E), \
+			(initSlots), \
+			(uint64_t (*)(const void *))(keyHash), \
+			(int (*)(const void *, const void *))(keyCompare), \
+			(void (*)(void *, const void *))(keyCopy), \
+			(void (*)(void *))(keyDeinit) \
+	)
+
+#define FoxFlatMapMDeinit(K, E, map) \
+	FoxFlatMapDeinit((map))
+
+#define FoxFlatMapMSize(K, E, map) \
+	FoxFlatMapSize((map))
+
+#define FoxFlatMapMEmpty(K, E, map) \
+	FoxFlatMapEmpty((map))
+
+#define FoxFlatMapMLoadFactor(K, E, map) \
+	FoxFlatMapLoadFactor((map))
+
+#define FoxFlatMapMIndex(K, E, map, key) \
+	({ \
+		K FoxFlatMapMIndex_key = (key); \
+		(E *)FoxFlatMapIndex((map), &FoxFlatMapMIndex_key); \
+	})
+
+#define FoxFlatMapMInsert(K, E, map, key) \
+	({ \
+		K FoxFlatMapMInsert_key = (key); \
+		(E *)FoxFlatMapInsert((map), &FoxFlatMapMInsert_key); \
+	})
+
+#define FoxFlatMapMRemove(K, E, map, key) \
+	({ \
+		K FoxFlatMapMRemove_key = (key); \
+		E FoxFlatMapMRemove_elem; \
+		FoxFlatMapRemove( \
+				(map), \
+				&FoxFlatMapMRemove_key, \
+				&FoxFlatMapMRemove_elem \
+		); \
+		FoxFlatMapMRemove_elem; \
+	})
+
+#define FoxFlatMapMForEachPair(K, E, map, callback, ctx) \
+	FoxFlatMapForEachPair( \
+			(map), \
+			(bool (*)(const void *, void *, void *))(callback), \
+			(ctx) \
+	)
+
+#define FoxFlatMapMForEachElement(K, E, map, callback, ctx) \
+	FoxFlatMapForEachElement( \
+			(map), \
+			(bool (*)(void *, void *))(callback), \
+			(ctx) \
+	)
+
+#define FoxFlatMapMForEachKey(K, E, map, callback, ctx) \
+	FoxFlatMapForEachKey( \
+			(map), \
+			(bool (*)(const void *, void *))(callback), \
+			(ctx) \
+	)
+
+
+
+#endif /* FOXUTILS_FLATMAPMACS_H */
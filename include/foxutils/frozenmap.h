@@ -0,0 +1,113 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2020 Garrett Russell Fairburn
+ * 
+ * @copyright This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ *
+ * @brief Immutable hash table built from a foxutils/map.h hash table.
+ *
+ * Keys are placed using a minimal perfect hash function, so every lookup
+ * examines exactly one entry and the table has no empty space. Keys are
+ * split into partitions by their hashes, and each partition gets its own
+ * perfect hash function (found by searching a "pilot" value for each small
+ * bucket of keys, in the style of PTHash), so partitions are built in
+ * parallel.
+ *
+ * Keys whose hashes are identical to another key's (which no hash function
+ * built on top of them can tell apart) are kept in a small overflow table
+ * sorted by hash, which is only searched when a lookup finds an entry with
+ * the right hash but a different key.
+ */
+#ifndef FOXUTILS_FROZENMAP_H
+#define FOXUTILS_FROZENMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "foxutils/map.h"
+
+
+
+/* ----- PUBLIC TYPES ----- */
+
+/**
+ * @brief Immutable hash table data structure.
+ *
+ * @note While it is possible to directly access this struct's members, using
+ * the functions provided by the foxutils/frozenmap.h module is preferred.
+ */
+typedef struct FoxFrozenMap {
+	unsigned char * buf; /**< Partitions, then pilots, then entries. */
+	const struct FoxFrozenMapPartition * partitions; /**< Partitions. */
+	const uint32_t * pilots; /**< Bucket pilots of every partition. */
+	unsigned char * entries; /**< Entries which wrap keys and elements. */
+	unsigned char * overflow; /**< Overflow entries (sorted by hash). */
+	size_t numOverflow; /**< Number of overflow entries. */
+	size_t numPartitions; /**< Number of partitions. */
+	size_t size; /**< Number of key-element pairs. */
+	unsigned int (* keyHash)(const void *); /**< Key hashing function. */
+	uint64_t (* keyHash64)(const void *); /**< 64-bit key hashing
+																					function. */
+	uint64_t (* keyHashSeeded)(const void *, uint64_t); /**< Seeded key
+																								hashing function. */
+	uint64_t (* keyHashKeyed)(const void *, const FoxHashKey *); /**< Keyed key
+																										hashing function. */
+	FoxHashKey hashKey; /**< Hash key (or seed) of the original map. */
+	bool keyedHash; /**< Whether or not keys are hashed with a keyed hash
+										function. */
+	int (* keyCompare)(const void *, const void *); /**< Key comparison
+																										function. */
+	void (* keyDeinit)(void *); /**< Key de-initialization function. */
+	size_t keySize; /**< Size (in bytes) of each map key. */
+	size_t elemSize; /**< Size (in bytes) of each map element. */
+	size_t entrySize; /**< Size (in bytes) of each entry. */
+} FoxFrozenMap;
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+/**
+ * Allocate and initialize an immutable copy of a map.
+ *
+ * Keys are copied with the map's key duplication function, and the map
+ * itself is left unchanged. Maps without a key duplication function have
+ * their keys copied bytewise, and the frozen map then never de-initializes
+ * them (so they must outlive it).
+ *
+ * @return New frozen map, or NULL if no perfect hash function could be found
+ * (which is vanishingly unlikely).
+ */
+FoxFrozenMap * FoxMapFreeze(FoxMap * map);
+
+void FoxFrozenMapFree(FoxFrozenMap * frozen);
+
+/**
+ * @return Whether or not the map could be frozen (see FoxMapFreeze()).
+ */
+bool FoxFrozenMapInit(
+		FoxFrozenMap * frozen,
+		FoxMap * map
+);
+
+void FoxFrozenMapDeinit(FoxFrozenMap * frozen);
+
+size_t FoxFrozenMapSize(FoxFrozenMap * frozen);
+
+const void * FoxFrozenMapIndex(
+		FoxFrozenMap * frozen,
+		const void * key
+);
+
+void FoxFrozenMapForEachPair(
+		FoxFrozenMap * frozen,
+		bool (* callback)(const void * key, const void * elem, void * ctx),
+		void * ctx
+);
+
+
+
+#endif /* FOXUTILS_FROZENMAP_H */
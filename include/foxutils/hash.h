@@ -8,6 +8,10 @@
  *
  * @brief Non-cryptographically secure hashing functions.
  *
+ * On x86-64 CPUs with AES-NI, inputs of 32 bytes or more are hashed with an
+ * AES-based backend, so hashes are only reproducible across machines if the
+ * library is built with FOXHASH_PORTABLE defined.
+ *
  * @warning None of the functions in this module are crytographically secure.
  */
 #ifndef FOXUTILS_HASH_H
@@ -15,6 +19,44 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+
+
+
+/* ----- PUBLIC TYPES ----- */
+
+/**
+ * @brief 128-bit key of a keyed hash function.
+ */
+typedef struct FoxHashKey {
+	uint64_t k0; /**< First half of key. */
+	uint64_t k1; /**< Second half of key. */
+} FoxHashKey;
+
+/**
+ * @brief 128-bit hash.
+ */
+typedef struct FoxHash128 {
+	uint64_t lo; /**< First half of hash. */
+	uint64_t hi; /**< Second half of hash. */
+} FoxHash128;
+
+/**
+ * @brief Incremental hashing state.
+ *
+ * Produces the same hash as FoxHashMem() over the concatenation of every
+ * chunk passed to FoxHasherUpdate(), however the input is split.
+ *
+ * @note While it is possible to directly access this struct's members, using
+ * the functions provided by the foxutils/hash.h module is preferred.
+ */
+typedef struct FoxHasher {
+	uint64_t state; /**< Mixed state of every complete block. */
+	uint64_t block; /**< Bytes of the incomplete block (if any). */
+	size_t num; /**< Number of bytes hashed so far. */
+	uint64_t lanes[4]; /**< Mixed state of the AES-NI backend. */
+	unsigned char buffer[32]; /**< Incomplete block of the AES-NI backend. */
+} FoxHasher;
 
 
 
@@ -25,8 +67,198 @@ uint64_t FoxHashMem(
 		size_t num
 );
 
+/**
+ * Equivalent to FoxHashMem(), but starting from a seed.
+ *
+ * Seeding varies where keys land in a hash table, but keys which collide
+ * under one seed collide under every seed. Use FoxHashMemKeyed() for keys
+ * which may be chosen by an adversary.
+ */
+uint64_t FoxHashMemSeeded(
+		const void * mem,
+		size_t num,
+		uint64_t seed
+);
+
+/**
+ * Hash memory with SipHash-1-3, whose collisions cannot be predicted without
+ * the key.
+ *
+ * This is several times slower than FoxHashMem(), so it is best reserved for
+ * keys which may be chosen by an adversary.
+ */
+uint64_t FoxHashMemKeyed(
+		const void * mem,
+		size_t num,
+		const FoxHashKey * key
+);
+
+/**
+ * Hash memory into 128 bits (two independently well-mixed halves), enough to
+ * fingerprint content where 64-bit collisions would be likely.
+ */
+FoxHash128 FoxHashMem128(
+		const void * mem,
+		size_t num
+);
+
+/**
+ * Equivalent to FoxHashMem(str, strlen(str)), but in a single pass.
+ */
 uint64_t FoxHashString(const char * str);
 
+/**
+ * Equivalent to FoxHashMemSeeded(str, strlen(str), seed).
+ */
+uint64_t FoxHashStringSeeded(
+		const char * str,
+		uint64_t seed
+);
+
+/**
+ * Equivalent to FoxHashMemKeyed(str, strlen(str), key).
+ */
+uint64_t FoxHashStringKeyed(
+		const char * str,
+		const FoxHashKey * key
+);
+
+/**
+ * Equivalent to FoxHashMem128(str, strlen(str)).
+ */
+FoxHash128 FoxHashString128(const char * str);
+
+/**
+ * Generate a random hash key.
+ *
+ * The process draws one key from the operating system's entropy source, and
+ * every call derives a distinct key from it.
+ */
+void FoxHashKeyRandom(FoxHashKey * key);
+
+/**
+ * Hash a batch of 64-bit keys, writing the hash of each into out.
+ *
+ * Produces the same hashes as FoxHashULongLong(), but processes several keys
+ * at once (with AVX2, when the CPU supports it).
+ */
+void FoxHashU64Many(
+		const uint64_t * in,
+		size_t num,
+		uint64_t * out
+);
+
+/**
+ * Batched equivalent of FoxHashUInt() for 32-bit keys (see FoxHashU64Many()).
+ */
+void FoxHashU32Many(
+		const uint32_t * in,
+		size_t num,
+		uint64_t * out
+);
+
+/**
+ * Batched equivalent of FoxHashMem() for num keys of stride bytes each,
+ * stored contiguously in in (see FoxHashU64Many()).
+ */
+void FoxHashMemMany(
+		const void * in,
+		size_t stride,
+		size_t num,
+		uint64_t * out
+);
+
+void FoxHasherInit(FoxHasher * hasher);
+
+void FoxHasherUpdate(
+		FoxHasher * hasher,
+		const void * mem,
+		size_t num
+);
+
+/**
+ * @return Hash of every byte passed to FoxHasherUpdate() so far (the hasher
+ * is left unchanged, so it may continue to be updated).
+ */
+uint64_t FoxHasherFinal(FoxHasher * hasher);
+
+/**
+ * Inline equivalent of FoxHashMemSeeded(&val, sizeof(val), seed), so that
+ * hashing an integer key costs no call (as in custom FoxMap key hashing
+ * functions).
+ */
+static inline uint64_t FoxHashU64Seeded(
+		uint64_t val,
+		uint64_t seed
+) {
+	uint64_t state = seed ^ val;
+
+	/* Mix block. */
+	state ^= state << 12;
+	state ^= state >> 25;
+	state ^= state << 27;
+
+	/* Finalize hash. */
+	state += 0x9e3779b97f4a7c15ull;
+	state = (state ^ (state >> 30)) * 0xbf58476d1ce4e5b9ull;
+	state = (state ^ (state >> 27)) * 0x94d049bb133111ebull;
+
+	return state ^ (state >> 31);
+}
+
+/**
+ * Inline equivalent of FoxHashMemSeeded(&val, sizeof(val), seed).
+ */
+static inline uint64_t FoxHashU32Seeded(
+		uint32_t val,
+		uint64_t seed
+) {
+	/* The key's bytes occupy the first bytes of the block in memory. */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return FoxHashU64Seeded((uint64_t)val << 32, seed);
+#else
+	return FoxHashU64Seeded(val, seed);
+#endif
+}
+
+/**
+ * Inline equivalent of FoxHashULongLong() for 64-bit keys.
+ */
+static inline uint64_t FoxHashU64(uint64_t val) {
+	return FoxHashU64Seeded(val, 0);
+}
+
+/**
+ * Inline equivalent of FoxHashUInt() for 32-bit keys.
+ */
+static inline uint64_t FoxHashU32(uint32_t val) {
+	return FoxHashU32Seeded(val, 0);
+}
+
+/**
+ * Equivalent of FoxHashMemSeeded(key, size, seed) which hashes 64-bit and
+ * 32-bit keys inline (as the map modules do for keys without custom hashing
+ * functions).
+ */
+static inline uint64_t FoxHashKeySeeded(
+		const void * key,
+		size_t size,
+		uint64_t seed
+) {
+	if (size == sizeof(uint64_t)) {
+		uint64_t val;
+		memcpy(&val, key, sizeof(uint64_t));
+		return FoxHashU64Seeded(val, seed);
+	}
+	if (size == sizeof(uint32_t)) {
+		uint32_t val;
+		memcpy(&val, key, sizeof(uint32_t));
+		return FoxHashU32Seeded(val, seed);
+	}
+
+	return FoxHashMemSeeded(key, size, seed);
+}
+
 uint64_t FoxHashChar(char val);
 
 uint64_t FoxHashSChar(signed char val);
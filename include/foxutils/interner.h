@@ -0,0 +1,116 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2020 Garrett Russell Fairburn
+ * 
+ * @copyright This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ *
+ * @brief String interning table.
+ *
+ * Each distinct string is stored once and assigned a small, stable integer
+ * ID (assigned sequentially from 0), so interned strings can be compared by
+ * ID instead of with strcmp().
+ */
+#ifndef FOXUTILS_INTERNER_H
+#define FOXUTILS_INTERNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "foxutils/arena.h"
+#include "foxutils/array.h"
+#include "foxutils/map.h"
+
+
+
+/* ----- PUBLIC MACROS ----- */
+
+/**
+ * ID returned when looking up a string which has not been interned.
+ */
+#define FOXINTERNER_NULL_ID UINT32_MAX
+
+
+
+/* ----- PUBLIC TYPES ----- */
+
+/**
+ * @brief String interning table data structure.
+ *
+ * @note While it is possible to directly access this struct's members, using
+ * the functions provided by the foxutils/interner.h module is preferred.
+ */
+typedef struct FoxInterner {
+	FoxMap ids; /**< Map from canonical strings to their IDs. */
+	FoxArray strings; /**< Canonical strings (indexed by ID). */
+	FoxArena arena; /**< Storage of canonical strings. */
+} FoxInterner;
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+FoxInterner * FoxInternerNew(void);
+
+void FoxInternerFree(FoxInterner * interner);
+
+void FoxInternerInit(FoxInterner * interner);
+
+void FoxInternerDeinit(FoxInterner * interner);
+
+size_t FoxInternerSize(FoxInterner * interner);
+
+/**
+ * @return ID of string (which is interned first if necessary).
+ */
+uint32_t FoxInternerIntern(
+		FoxInterner * interner,
+		const char * str
+);
+
+/**
+ * Equivalent to FoxInternerIntern(), but for a string of len characters
+ * (which need not be NUL-terminated).
+ */
+uint32_t FoxInternerInternN(
+		FoxInterner * interner,
+		const char * str,
+		size_t len
+);
+
+/**
+ * @return ID of string, or FOXINTERNER_NULL_ID if it has not been interned.
+ */
+uint32_t FoxInternerFind(
+		FoxInterner * interner,
+		const char * str
+);
+
+/**
+ * Equivalent to FoxInternerFind(), but for a string of len characters (which
+ * need not be NUL-terminated).
+ */
+uint32_t FoxInternerFindN(
+		FoxInterner * interner,
+		const char * str,
+		size_t len
+);
+
+/**
+ * @return Canonical (NUL-terminated) copy of the string with an ID, which
+ * remains valid until the interner is de-initialized.
+ */
+const char * FoxInternerString(
+		FoxInterner * interner,
+		uint32_t id
+);
+
+size_t FoxInternerLength(
+		FoxInterner * interner,
+		uint32_t id
+);
+
+
+
+#endif /* FOXUTILS_INTERNER_H */
@@ -17,8 +17,11 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
+#include "foxutils/arena.h"
 #include "foxutils/array.h"
+#include "foxutils/hash.h"
 
 
 
@@ -32,6 +35,8 @@
 
 #define FOXMAP_NULL_LFTHRESH -1.0f
 
+#define FOXMAP_DEF_ROBINHOOD_LFTHRESH 0.875f
+
 
 
 /* ----- PUBLIC TYPES ----- */
@@ -43,19 +48,46 @@
  * the functions provided by the foxutils/map.h module is preferred.
  */
 typedef struct FoxMap {
-	FoxArray slots; /**< Map slots (or "buckets") which wrap keys. */
-	FoxArray items; /**< Map items which wrap elements. */
+	FoxArray slots; /**< Map slots (or "buckets") which hold the index of the
+										first item in their chains. */
+	unsigned char ** itemChunks; /**< Chunks of map items which wrap keys and
+																elements (and link slot chains). */
+	size_t numItemChunks; /**< Number of item chunks (each twice the size of
+													the last). */
+	size_t numItems; /**< Number of map items. */
+	size_t itemSize; /**< Size (in bytes) of each map item. */
 	unsigned int (* keyHash)(const void *); /**< Key hashing function. */
+	uint64_t (* keyHash64)(const void *); /**< 64-bit key hashing function
+																					(overrides keyHash). */
+	uint64_t (* keyHashSeeded)(const void *, uint64_t); /**< Seeded key
+																								hashing function (overrides
+																								keyHash64). */
+	uint64_t (* keyHashKeyed)(const void *, const FoxHashKey *); /**< Keyed key
+																										hashing function. */
+	FoxHashKey hashKey; /**< Random, per-map hash key (or seed). */
+	bool keyedHash; /**< Whether or not keys are hashed with a keyed hash
+										function. */
 	int (* keyCompare)(const void *, const void *); /**< Key comparison
 																										function. */
 	void (* keyCopy)(void *, const void *); /**< Key duplication function. */
 	void (* keyDeinit)(void *); /**< Key de-initialization function. */
+	FoxArena * keyArena; /**< Arena which owns key copies (or NULL). */
+	void (* keyArenaCopy)(void *, const void *, FoxArena *); /**< Arena key
+																				duplication function. */
 	size_t keySize; /**< Size (in bytes) of each map key. */
 	size_t elemSize; /**< Size (in bytes) of each map element. */
 	float growRate; /**< Map growth rate. */
 	float lfThresh; /**< Load factor growth threshold. */
-	unsigned int slotIdxMask; /**< Binary mask applied to hashed keys to
-															generate a slot index. */
+	size_t slotIdxMask; /**< Binary mask applied to hashed keys to generate a
+												slot index. */
+	FoxArray oldSlots; /**< Slots being migrated during an incremental
+											expansion (empty otherwise). */
+	size_t oldSlotIdxMask; /**< Slot index mask of old slots. */
+	size_t migrateIdx; /**< Index of next old slot to migrate. */
+	size_t migrateRate; /**< Number of old slots to migrate per operation
+												(0 for non-incremental expansion). */
+	bool robinHood; /**< Whether slots use Robin Hood linear probing instead
+										of chaining. */
 } FoxMap;
 
 
@@ -89,6 +121,38 @@ void FoxMapInit(
 		void (* keyDeinit)(void * key)
 );
 
+/**
+ * Equivalent to FoxMapNew(), but with a key hashing function which returns
+ * all 64 bits of its hash.
+ *
+ * Maps created by FoxMapNew() only see 32 bits of a custom key hash, which
+ * limits them to 2^32 slots and leaves no high bits for callers to use.
+ */
+FoxMap * FoxMapNew64(
+		size_t keySize,
+		size_t elemSize,
+		size_t initSlots,
+		float growRate,
+		float lfThresh,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void * copy, const void * key),
+		void (* keyDeinit)(void * key)
+);
+
+void FoxMapInit64(
+		FoxMap * map,
+		size_t keySize,
+		size_t elemSize,
+		size_t initSlots,
+		float growRate,
+		float lfThresh,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void * copy, const void * key),
+		void (* keyDeinit)(void * key)
+);
+
 void FoxMapDeinit(FoxMap * map);
 
 size_t FoxMapSize(FoxMap * map);
@@ -97,24 +161,203 @@ bool FoxMapEmpty(FoxMap * map);
 
 float FoxMapLoadFactor(FoxMap * map);
 
+/**
+ * Enable incremental expansion by setting how many old slots are migrated
+ * (and how many of the expanded slot table's slots are initialized) by each
+ * index, insert or removal.
+ *
+ * With a migration rate of 0 (the default), an expansion migrates every slot
+ * at once inside a single call to FoxMapInsert().
+ */
+void FoxMapSetMigrateRate(
+		FoxMap * map,
+		size_t migrateRate
+);
+
+bool FoxMapMigrating(FoxMap * map);
+
+/**
+ * Switch between chaining (the default) and Robin Hood linear probing.
+ *
+ * With Robin Hood probing, each slot refers to at most one item, items are
+ * kept close to their home slots (bounding probe lengths even at high load
+ * factors) and removals shift later items back rather than leaving
+ * tombstones. Items remain in one dense array either way.
+ *
+ * Because probing requires more slots than items, switching to Robin Hood
+ * probing replaces any load factor threshold outside of (0, 1) with
+ * FOXMAP_DEF_ROBINHOOD_LFTHRESH. Expansions in this mode are never
+ * incremental.
+ */
+void FoxMapSetRobinHood(
+		FoxMap * map,
+		bool robinHood
+);
+
+bool FoxMapRobinHood(FoxMap * map);
+
+/**
+ * Hash keys with functions of the map's random hash key instead of the map's
+ * unseeded key hashing functions. The map must be empty.
+ *
+ * Maps without key hashing functions of their own already hash keys with a
+ * random seed. A seed only varies where keys land, since keys which collide
+ * under one seed collide under every seed, so use FoxMapSetKeyedHash() for
+ * keys which may be chosen by an adversary.
+ *
+ * @param[in] keyHashSeeded Key hashing function which receives the map's
+ * seed.
+ * @param[in] keyHashKeyed Key hashing function (for FoxMapSetKeyedHash()) which
+ * receives the map's hash key, or NULL if the map's keys cannot be hashed
+ * with a keyed function.
+ */
+void FoxMapSetSeededHash(
+		FoxMap * map,
+		uint64_t (* keyHashSeeded)(const void * key, uint64_t seed),
+		uint64_t (* keyHashKeyed)(const void * key, const FoxHashKey * hashKey)
+);
+
+/**
+ * Set whether or not keys are hashed with a keyed hash function (SipHash-1-3
+ * for maps without key hashing functions of their own), which keeps lookups
+ * fast even when keys are chosen by an adversary to collide. The map must be
+ * empty.
+ */
+void FoxMapSetKeyedHash(
+		FoxMap * map,
+		bool keyedHash
+);
+
+bool FoxMapKeyedHash(FoxMap * map);
+
+/**
+ * Store key copies in an arena owned by the map instead of copying each one
+ * with the map's key duplication function. The map must be empty.
+ *
+ * keyCopy receives the arena to allocate from. Arena memory is freed all at
+ * once by FoxMapDeinit() (so removed keys keep their memory until then), and
+ * the map's key de-initialization function is no longer called. Copies of
+ * keys made outside of the map (such as by FoxMapFreeze()) still use the
+ * map's own key functions.
+ */
+void FoxMapSetKeyArena(
+		FoxMap * map,
+		void (* keyCopy)(void * copy, const void * key, FoxArena * arena),
+		size_t chunkSize
+);
+
 void FoxMapExpand(FoxMap * map);
 
+/**
+ * Make room for a total of numItems items so that inserting them causes no
+ * further allocation of items or expansion of slots.
+ */
+void FoxMapReserve(
+		FoxMap * map,
+		size_t numItems
+);
+
+/**
+ * Rebuild the map with the smallest slot table which satisfies its load
+ * factor threshold, and release all unused slot and item capacity.
+ */
+void FoxMapShrink(FoxMap * map);
+
+uint64_t FoxMapKeyHash(
+		FoxMap * map,
+		const void * key
+);
+
 void * FoxMapIndex(
 		FoxMap * map,
 		const void * key
 );
 
+/**
+ * Equivalent to FoxMapIndex(), but with a key hash previously obtained from
+ * FoxMapKeyHash().
+ */
+void * FoxMapIndexHashed(
+		FoxMap * map,
+		const void * key,
+		uint64_t hash
+);
+
+/**
+ * Equivalent to FoxMapIndexHashed(), but keys are compared with keyCompare,
+ * which receives key as its first argument and a map key as its second. This
+ * allows key to have a different type than the map's keys (so long as it
+ * hashes to the same value as the map key it is equal to).
+ */
+void * FoxMapIndexHashedCompare(
+		FoxMap * map,
+		const void * key,
+		uint64_t hash,
+		int (* keyCompare)(const void *, const void *)
+);
+
+/**
+ * Equivalent to FoxMapIndexHashed(), but without performing any incremental
+ * expansion work (see FoxMapSetMigrateRate()). The map is left unmodified, so
+ * concurrent calls are safe while no thread modifies the map.
+ */
+void * FoxMapFindHashed(
+		FoxMap * map,
+		const void * key,
+		uint64_t hash
+);
+
+/**
+ * Index a batch of keys (stored contiguously in keys), writing a pointer to
+ * each key's element (or NULL) into elems.
+ *
+ * Every key is hashed and its slot prefetched before any of them are
+ * resolved, which hides much of the memory latency of large maps.
+ */
+void FoxMapIndexMany(
+		FoxMap * map,
+		const void * keys,
+		size_t numKeys,
+		void ** elems
+);
+
 void * FoxMapInsert(
 		FoxMap * map,
 		const void * key
 );
 
+void * FoxMapInsertHashed(
+		FoxMap * map,
+		const void * key,
+		uint64_t hash
+);
+
+/**
+ * Batched equivalent of FoxMapInsert() (see FoxMapIndexMany()).
+ *
+ * None of the keys may already be present, and all of the pointers written
+ * into elems remain valid until the map is next modified.
+ */
+void FoxMapInsertMany(
+		FoxMap * map,
+		const void * keys,
+		size_t numKeys,
+		void ** elems
+);
+
 void FoxMapRemove(
 		FoxMap * map,
 		const void * key,
 		void * elem
 );
 
+void FoxMapRemoveHashed(
+		FoxMap * map,
+		const void * key,
+		uint64_t hash,
+		void * elem
+);
+
 void FoxMapForEachPair(
 		FoxMap * map,
 		bool (* callback)(const void * key, void * elem, void * ctx),
@@ -11,6 +11,11 @@
 #ifndef FOXUTILS_MAPMACS_H
 #define FOXUTILS_MAPMACS_H
 
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
 #include "foxutils/map.h"
 
 
@@ -52,6 +57,25 @@
 			NULL \
 	)
 
+#define FoxMapMNew64Ext( \
+		K, \
+		E, \
+		initSlots, \
+		keyHash, \
+		keyCompare \
+) \
+	FoxMapNew64( \
+			sizeof(K), \
+			sizeof(E), \
+			(initSlots), \
+			FOXMAP_DEF_GROWRATE, \
+			FOXMAP_DEF_LFTHRESH, \
+			(uint64_t (*)(const void *))(keyHash), \
+			(int (*)(const void *, const void *))(keyCompare), \
+			NULL, \
+			NULL \
+	)
+
 #define FoxMapMNewAdv( \
 		K, \
 		E, \
@@ -75,6 +99,29 @@
 			(void (*)(void *))(keyDeinit) \
 	)
 
+#define FoxMapMNew64Adv( \
+		K, \
+		E, \
+		initSlots, \
+		growRate, \
+		lfThresh, \
+		keyHash, \
+		keyCompare, \
+		keyCopy, \
+		keyDeinit \
+) \
+	FoxMapNew64( \
+			sizeof(K), \
+			sizeof(E), \
+			(initSlots), \
+			(growRate), \
+			(lfThresh), \
+			(uint64_t (*)(const void *))(keyHash), \
+			(int (*)(const void *, const void *))(keyCompare), \
+			(void (*)(void *, const void *))(keyCopy), \
+			(void (*)(void *))(keyDeinit) \
+	)
+
 #define FoxMapMFree(K, E, map) \
 	FoxMapFree((map))
 
@@ -117,6 +164,27 @@
 			NULL \
 	)
 
+#define FoxMapMInit64Ext( \
+		K, \
+		E, \
+		map, \
+		initSlots, \
+		keyHash, \
+		keyCompare \
+) \
+	FoxMapInit64( \
+			(map), \
+			sizeof(K), \
+			sizeof(E), \
+			(initSlots), \
+			FOXMAP_DEF_GROWRATE, \
+			FOXMAP_DEF_LFTHRESH, \
+			(uint64_t (*)(const void *))(keyHash), \
+			(int (*)(const void *, const void *))(keyCompare), \
+			NULL, \
+			NULL \
+	)
+
 #define FoxMapMInitAdv( \
 		K, \
 		E, \
@@ -142,6 +210,31 @@
 			(void (*)(void *))(keyDeinit) \
 	)
 
+#define FoxMapMInit64Adv( \
+		K, \
+		E, \
+		map, \
+		initSlots, \
+		growRate, \
+		lfThresh, \
+		keyHash, \
+		keyCompare, \
+		keyCopy, \
+		keyDeinit \
+) \
+	FoxMapInit64( \
+			(map), \
+			sizeof(K), \
+			sizeof(E), \
+			(initSlots), \
+			(growRate), \
+			(lfThresh), \
+			(uint64_t (*)(const void *))(keyHash), \
+			(int (*)(const void *, const void *))(keyCompare), \
+			(void (*)(void *, const void *))(keyCopy), \
+			(void (*)(void *))(keyDeinit) \
+	)
+
 #define FoxMapMDeinit(K, E, map) \
 	FoxMapDeinit((map))
 
@@ -154,9 +247,21 @@
 #define FoxMapMLoadFactor(K, E, map) \
 	FoxMapLoadFactor((map))
 
+#define FoxMapMSetRobinHood(K, E, map, robinHood) \
+	FoxMapSetRobinHood((map), (robinHood))
+
+#define FoxMapMSetKeyedHash(K, E, map, keyedHash) \
+	FoxMapSetKeyedHash((map), (keyedHash))
+
 #define FoxMapMExpand(K, E, map) \
 	FoxMapExpand((map))
 
+#define FoxMapMReserve(K, E, map, numItems) \
+	FoxMapReserve((map), (numItems))
+
+#define FoxMapMShrink(K, E, map) \
+	FoxMapShrink((map))
+
 #define FoxMapMIndex(K, E, map, key) \
 	({ \
 		K FoxMapMIndex_key = (key); \
@@ -198,6 +303,178 @@
 			(ctx) \
 	)
 
+/**
+ * Define a typed hash table named name, mapping keys of type K to elements of
+ * type E, along with static inline functions name##New(), name##Free(),
+ * name##Init(), name##Deinit(), name##Size(), name##Index(), name##Insert(),
+ * name##Remove() and name##ForEachPair().
+ *
+ * Unlike FoxMap, key and element sizes are known at compile time, and keyHash
+ * (any function or macro taking a K and returning uint64_t) and keyEqual (any
+ * function or macro taking two Ks and returning non-zero if they are equal)
+ * can be inlined. Keys and elements are copied by assignment and are never
+ * de-initialized, and the table grows by doubling at a load factor of 1.
+ * Otherwise these functions behave like their FoxMap counterparts.
+ */
+#define FOXMAP_DEFINE(name, K, E, keyHash, keyEqual) \
+	typedef struct name##Item { \
+		uint64_t hash; \
+		size_t next; \
+		K key; \
+		E elem; \
+	} name##Item; \
+	\
+	typedef struct name { \
+		size_t * slots; \
+		name##Item * items; \
+		size_t slotIdxMask; \
+		size_t size; \
+		size_t cap; \
+	} name; \
+	\
+	static inline void name##FillSlots(name * map) { \
+		for (size_t idx = 0; idx <= map->slotIdxMask; idx++) { \
+			map->slots[idx] = SIZE_MAX; \
+		} \
+		for (size_t idx = 0; idx < map->size; idx++) { \
+			name##Item * item = map->items + idx; \
+			size_t * slot = map->slots + (item->hash & map->slotIdxMask); \
+			item->next = *slot; \
+			*slot = idx; \
+		} \
+	\
+		return; \
+	} \
+	\
+	static inline void name##Init(name * map) { \
+		*map = (name){.slotIdxMask = FOXMAP_DEF_INITSLOTS - 1}; \
+		map->slots = malloc(FOXMAP_DEF_INITSLOTS * sizeof(size_t)); \
+		assert(map->slots); \
+		name##FillSlots(map); \
+	\
+		return; \
+	} \
+	\
+	static inline void name##Deinit(name * map) { \
+		free(map->slots); \
+		free(map->items); \
+		*map = (name){0}; \
+	\
+		return; \
+	} \
+	\
+	static inline name * name##New(void) { \
+		name * map = malloc(sizeof(name)); \
+		assert(map); \
+		name##Init(map); \
+	\
+		return map; \
+	} \
+	\
+	static inline void name##Free(name * map) { \
+		name##Deinit(map); \
+		free(map); \
+	\
+		return; \
+	} \
+	\
+	static inline size_t name##Size(name * map) { \
+		return map->size; \
+	} \
+	\
+	static inline size_t * name##Lookup( \
+			name * map, \
+			K key, \
+			uint64_t hash \
+	) { \
+		size_t * link = map->slots + (hash & map->slotIdxMask); \
+		while (*link != SIZE_MAX) { \
+			name##Item * item = map->items + *link; \
+			if (item->hash == hash && keyEqual(key, item->key)) break; \
+			link = &item->next; \
+		} \
+	\
+		return link; \
+	} \
+	\
+	static inline E * name##Index( \
+			name * map, \
+			K key \
+	) { \
+		size_t itemIdx = *name##Lookup(map, key, keyHash(key)); \
+	\
+		return (itemIdx == SIZE_MAX) ? NULL : &map->items[itemIdx].elem; \
+	} \
+	\
+	static inline E * name##Insert( \
+			name * map, \
+			K key \
+	) { \
+		uint64_t hash = keyHash(key); \
+		assert(*name##Lookup(map, key, hash) == SIZE_MAX); \
+	\
+		/* Expand items and slots if necessary. */ \
+		if (map->size == map->cap) { \
+			map->cap = (map->cap) ? map->cap * 2 : FOXARRAY_DEF_INITCAP; \
+			map->items = realloc(map->items, map->cap * sizeof(name##Item)); \
+			assert(map->items); \
+		} \
+		if (map->size > map->slotIdxMask) { \
+			size_t numSlots = (map->slotIdxMask + 1) * 2; \
+			map->slots = realloc(map->slots, numSlots * sizeof(size_t)); \
+			assert(map->slots); \
+			map->slotIdxMask = numSlots - 1; \
+			name##FillSlots(map); \
+		} \
+	\
+		/* Create item and link it at head of slot chain. */ \
+		size_t itemIdx = map->size++; \
+		name##Item * item = map->items + itemIdx; \
+		size_t * slot = map->slots + (hash & map->slotIdxMask); \
+		*item = (name##Item){.hash = hash, .next = *slot, .key = key}; \
+		*slot = itemIdx; \
+	\
+		return &item->elem; \
+	} \
+	\
+	static inline void name##Remove( \
+			name * map, \
+			K key, \
+			E * elem \
+	) { \
+		size_t * link = name##Lookup(map, key, keyHash(key)); \
+		size_t itemIdx = *link; \
+		assert(itemIdx != SIZE_MAX); \
+		name##Item * item = map->items + itemIdx; \
+		if (elem) *elem = item->elem; \
+		*link = item->next; \
+	\
+		/* Move last item into the hole. */ \
+		size_t lastItemIdx = --map->size; \
+		if (itemIdx < lastItemIdx) { \
+			name##Item * lastItem = map->items + lastItemIdx; \
+			link = map->slots + (lastItem->hash & map->slotIdxMask); \
+			while (*link != lastItemIdx) link = &map->items[*link].next; \
+			*link = itemIdx; \
+			*item = *lastItem; \
+		} \
+	\
+		return; \
+	} \
+	\
+	static inline void name##ForEachPair( \
+			name * map, \
+			bool (* callback)(const K * key, E * elem, void * ctx), \
+			void * ctx \
+	) { \
+		for (size_t idx = 0; idx < map->size; idx++) { \
+			name##Item * item = map->items + idx; \
+			if (!callback(&item->key, &item->elem, ctx)) break; \
+		} \
+	\
+		return; \
+	}
+
 
 
 #endif /* FOXUTILS_MAPMACS_H */
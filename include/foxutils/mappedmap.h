@@ -0,0 +1,121 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2020 Garrett Russell Fairburn
+ * 
+ * @copyright This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ *
+ * @brief Read-only hash table served directly from a memory-mapped file.
+ *
+ * FoxMapSave() and FoxStringMapSave() write a map to a single relocatable
+ * file (which stores offsets instead of pointers), and FoxMapOpenMapped()
+ * maps that file into memory and answers lookups from it without any
+ * deserialization. Processes which open the same file share its pages.
+ *
+ * The file format uses its own hash function (rather than the map's), so
+ * files remain valid across processes and library versions. Files are only
+ * portable between machines with the same byte order.
+ */
+#ifndef FOXUTILS_MAPPEDMAP_H
+#define FOXUTILS_MAPPEDMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "foxutils/map.h"
+
+
+
+/* ----- PUBLIC TYPES ----- */
+
+/**
+ * @brief Read-only, memory-mapped hash table data structure.
+ *
+ * @note While it is possible to directly access this struct's members, using
+ * the functions provided by the foxutils/mappedmap.h module is preferred.
+ */
+typedef struct FoxMappedMap {
+	const unsigned char * base; /**< Start of mapped file. */
+	size_t fileSize; /**< Size (in bytes) of mapped file. */
+	const unsigned char * slots; /**< Slots which wrap keys and elements. */
+	const char * strings; /**< String keys (if any). */
+	size_t stringsSize; /**< Size (in bytes) of string keys. */
+	size_t numSlots; /**< Number of slots. */
+	size_t size; /**< Number of key-element pairs. */
+	size_t keySize; /**< Size (in bytes) of each map key. */
+	size_t elemSize; /**< Size (in bytes) of each map element. */
+	size_t slotSize; /**< Size (in bytes) of each slot. */
+	bool stringKeys; /**< Whether or not keys are C strings. */
+} FoxMappedMap;
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+/**
+ * Write a map to a file which can be opened with FoxMapOpenMapped().
+ *
+ * Keys are stored, hashed and compared bytewise, so only keys which are equal
+ * exactly when their bytes are equal (and which hold no pointers) can be
+ * saved. The map must not use a key comparison function, key duplication
+ * function or key arena. Use FoxStringMapSave() for foxutils/stringmap.h maps.
+ *
+ * The file is replaced atomically, so maps which are already open on it are
+ * unaffected.
+ *
+ * @return Whether or not the file was written successfully.
+ */
+bool FoxMapSave(
+		FoxMap * map,
+		const char * path
+);
+
+/**
+ * Write a foxutils/stringmap.h map to a file which can be opened with
+ * FoxMapOpenMapped().
+ *
+ * @return Whether or not the file was written successfully.
+ */
+bool FoxStringMapSave(
+		FoxMap * map,
+		const char * path
+);
+
+/**
+ * Allocate a read-only map and initialize it from a file written by
+ * FoxMapSave() or FoxStringMapSave().
+ *
+ * @return New mapped map, or NULL if the file could not be mapped or is not
+ * a valid map file.
+ */
+FoxMappedMap * FoxMapOpenMapped(const char * path);
+
+void FoxMappedMapFree(FoxMappedMap * mapped);
+
+/**
+ * @return Whether or not the file could be opened (see FoxMapOpenMapped()).
+ */
+bool FoxMappedMapInit(
+		FoxMappedMap * mapped,
+		const char * path
+);
+
+void FoxMappedMapDeinit(FoxMappedMap * mapped);
+
+size_t FoxMappedMapSize(FoxMappedMap * mapped);
+
+/**
+ * @param key Key, or pointer to C string key if the file was written by
+ * FoxStringMapSave().
+ *
+ * @return Element, or NULL if the key is not present.
+ */
+const void * FoxMappedMapIndex(
+		FoxMappedMap * mapped,
+		const void * key
+);
+
+
+
+#endif /* FOXUTILS_MAPPEDMAP_H */
@@ -12,6 +12,7 @@
 #define FOXUTILS_RAND_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 
@@ -23,6 +24,11 @@ struct FoxPRNG;
 typedef struct FoxPRNGVTable {
 	void (* seed)(struct FoxPRNG * prng, uint64_t seed);
 	uint64_t (* next)(struct FoxPRNG * prng);
+	/**
+	 * Produce the next num values at once (optional, as FoxRandFillU64() falls
+	 * back on next).
+	 */
+	void (* fill)(struct FoxPRNG * prng, uint64_t * out, size_t num);
 } FoxPRNGVTable;
 
 typedef struct FoxPRNG {
@@ -72,6 +78,44 @@ double FoxRandDoubleRange(
 		double max
 );
 
+/**
+ * Fill out with the next num values of FoxRandUInt(), but without a call per
+ * value.
+ */
+void FoxRandFillU64(
+		FoxPRNG * prng,
+		uint64_t * out,
+		size_t num
+);
+
+/**
+ * Fill out with the next num values of FoxRandFloat().
+ */
+void FoxRandFillFloat(
+		FoxPRNG * prng,
+		float * out,
+		size_t num
+);
+
+/**
+ * Fill out with the next num values of FoxRandDouble().
+ */
+void FoxRandFillDouble(
+		FoxPRNG * prng,
+		double * out,
+		size_t num
+);
+
+/**
+ * Fill out with num random bytes, taken in memory order from as many values
+ * of FoxRandUInt() as necessary.
+ */
+void FoxRandFillBytes(
+		FoxPRNG * prng,
+		void * out,
+		size_t num
+);
+
 
 
 #endif /* FOXUTILS_RAND_H */
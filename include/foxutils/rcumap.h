@@ -0,0 +1,195 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2020 Garrett Russell Fairburn
+ * 
+ * @copyright This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ *
+ * @brief Read-optimized, thread-safe hash table implementation.
+ *
+ * Lookups never lock and never write to shared memory. Writers are serialized
+ * by a mutex and publish every change with release stores, so a reader
+ * always sees either the old or the new version of a chain. Nodes which
+ * writers unlink (along with their keys) are only reclaimed once every
+ * registered reader has announced a quiescent state, in the style of
+ * quiescent-state-based RCU.
+ *
+ * Each reading thread must register a FoxRcuMapReader and periodically call
+ * FoxRcuMapQuiescent() at a point where it holds no pointers obtained from
+ * the map (or FoxRcuMapOffline() before a long pause). A reader which never
+ * does so prevents reclamation but does not block writers.
+ */
+#ifndef FOXUTILS_RCUMAP_H
+#define FOXUTILS_RCUMAP_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "foxutils/array.h"
+
+
+
+/* ----- PUBLIC MACROS ----- */
+
+#define FOXRCUMAP_DEF_INITSLOTS 64ul
+
+#define FOXRCUMAP_DEF_GROWRATE 2.0f
+
+#define FOXRCUMAP_DEF_LFTHRESH 1.0f
+
+
+
+/* ----- PUBLIC TYPES ----- */
+
+struct FoxRcuMapTable;
+
+/**
+ * @brief Per-thread reader registration.
+ */
+typedef struct FoxRcuMapReader {
+	_Alignas(64) _Atomic uint64_t epoch; /**< Last announced epoch (0 while
+																				 offline). */
+} FoxRcuMapReader;
+
+/**
+ * @brief Read-optimized hash table data structure.
+ *
+ * @note While it is possible to directly access this struct's members, using
+ * the functions provided by the foxutils/rcumap.h module is preferred.
+ */
+typedef struct FoxRcuMap {
+	_Atomic(struct FoxRcuMapTable *) table; /**< Current bucket table. */
+	_Atomic uint64_t epoch; /**< Global epoch. */
+	_Atomic size_t size; /**< Number of key-element pairs. */
+	pthread_mutex_t writeLock; /**< Lock serializing writers. */
+	FoxArray readers; /**< Registered readers. */
+	FoxArray retired; /**< Unlinked memory awaiting reclamation. */
+	uint64_t (* keyHash)(const void *); /**< Key hashing function. */
+	int (* keyCompare)(const void *, const void *); /**< Key comparison
+																										function. */
+	void (* keyCopy)(void *, const void *); /**< Key duplication function. */
+	void (* keyDeinit)(void *); /**< Key de-initialization function. */
+	size_t keySize; /**< Size (in bytes) of each map key. */
+	size_t elemSize; /**< Size (in bytes) of each map element. */
+	size_t elemOffset; /**< Offset (in bytes) of element within node data. */
+	float growRate; /**< Map growth rate. */
+	float lfThresh; /**< Load factor growth threshold. */
+} FoxRcuMap;
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+FoxRcuMap * FoxRcuMapNew(
+		size_t keySize,
+		size_t elemSize,
+		size_t initSlots,
+		float growRate,
+		float lfThresh,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void * copy, const void * key),
+		void (* keyDeinit)(void * key)
+);
+
+void FoxRcuMapFree(FoxRcuMap * map);
+
+void FoxRcuMapInit(
+		FoxRcuMap * map,
+		size_t keySize,
+		size_t elemSize,
+		size_t initSlots,
+		float growRate,
+		float lfThresh,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void * copy, const void * key),
+		void (* keyDeinit)(void * key)
+);
+
+/**
+ * @note No reader may be using the map when it is de-initialized.
+ */
+void FoxRcuMapDeinit(FoxRcuMap * map);
+
+size_t FoxRcuMapSize(FoxRcuMap * map);
+
+/**
+ * Register the calling thread as a reader. The new reader starts online.
+ */
+FoxRcuMapReader * FoxRcuMapRegisterReader(FoxRcuMap * map);
+
+void FoxRcuMapUnregisterReader(
+		FoxRcuMap * map,
+		FoxRcuMapReader * reader
+);
+
+/**
+ * Announce that a reader holds no pointers obtained from the map (bringing
+ * it back online if it was offline).
+ */
+void FoxRcuMapQuiescent(
+		FoxRcuMap * map,
+		FoxRcuMapReader * reader
+);
+
+/**
+ * Take a reader offline so that it does not delay reclamation while it is
+ * not using the map.
+ */
+void FoxRcuMapOffline(
+		FoxRcuMap * map,
+		FoxRcuMapReader * reader
+);
+
+/**
+ * Get the element associated with a key.
+ *
+ * The returned element remains valid until the calling reader's next
+ * quiescent state and must not be modified.
+ */
+const void * FoxRcuMapIndex(
+		FoxRcuMap * map,
+		const void * key
+);
+
+/**
+ * Associate a copy of elem with a key, replacing any existing element.
+ */
+void FoxRcuMapInsert(
+		FoxRcuMap * map,
+		const void * key,
+		const void * elem
+);
+
+/**
+ * Remove a key (if present), copying its element into elem (can be NULL).
+ *
+ * @return Whether or not the key was present.
+ */
+bool FoxRcuMapRemove(
+		FoxRcuMap * map,
+		const void * key,
+		void * elem
+);
+
+/**
+ * Free all unlinked memory which no reader can still be using.
+ *
+ * Writers also do this automatically.
+ */
+void FoxRcuMapReclaim(FoxRcuMap * map);
+
+void FoxRcuMapForEachPair(
+		FoxRcuMap * map,
+		bool (* callback)(const void * key, const void * elem, void * ctx),
+		void * ctx
+);
+
+
+
+#endif /* FOXUTILS_RCUMAP_H */
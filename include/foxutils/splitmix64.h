@@ -49,6 +49,15 @@ void FoxSplitMix64Seed(
 
 uint64_t FoxSplitMix64Next(FoxSplitMix64 * prng);
 
+/**
+ * Equivalent to num calls to FoxSplitMix64Next(), storing the values in out.
+ */
+void FoxSplitMix64Fill(
+		FoxSplitMix64 * prng,
+		uint64_t * out,
+		size_t num
+);
+
 uint64_t FoxSplitMix64Primitive(uint64_t * state);
 
 
@@ -12,6 +12,10 @@
 #ifndef FOXUTILS_STRINGMAP_H
 #define FOXUTILS_STRINGMAP_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "foxutils/arena.h"
 #include "foxutils/map.h"
 
 
@@ -25,6 +29,14 @@ FoxMap * FoxStringMapNew(
 		float lfThresh
 );
 
+/**
+ * Initialize a string map.
+ *
+ * String keys often come from untrusted input, so they are hashed with a
+ * keyed hash function (see FoxMapSetKeyedHash()) by default. Call
+ * FoxMapSetKeyedHash(map, false) while the map is still empty to hash
+ * trusted keys with the faster seeded hash function instead.
+ */
 void FoxStringMapInit(
 		FoxMap * map,
 		size_t elemSize,
@@ -33,6 +45,74 @@ void FoxStringMapInit(
 		float lfThresh
 );
 
+/**
+ * Initialize a string map which borrows its keys instead of copying them.
+ * Every key inserted into the map must have been allocated with
+ * FoxStringMapKeyAlloc() and must outlive the map.
+ */
+void FoxStringMapInitBorrowed(
+		FoxMap * map,
+		size_t elemSize,
+		size_t initSlots,
+		float growRate,
+		float lfThresh
+);
+
+/**
+ * Copy a string of len characters (which need not be NUL-terminated) into
+ * arena, in the layout a string map stores its keys in.
+ *
+ * @return NUL-terminated copy, which can be passed to FoxStringMapKeyLength().
+ */
+const char * FoxStringMapKeyAlloc(
+		FoxArena * arena,
+		const char * str,
+		size_t len
+);
+
+/**
+ * @return Length of a key stored by a string map (or allocated with
+ * FoxStringMapKeyAlloc()) without scanning it.
+ */
+size_t FoxStringMapKeyLength(const char * key);
+
+/**
+ * Copy keys into chunks of memory owned by the map (see FoxMapSetKeyArena())
+ * instead of allocating each key separately. The map must be empty.
+ */
+void FoxStringMapUseArena(FoxMap * map);
+
+/**
+ * Hash a string of len characters (which need not be NUL-terminated) the
+ * same way as a string map hashes its keys.
+ */
+uint64_t FoxStringMapHash(
+		FoxMap * map,
+		const char * str,
+		size_t len
+);
+
+/**
+ * Equivalent to FoxMapIndex(), but for a key of len characters (which need
+ * not be NUL-terminated).
+ */
+void * FoxStringMapIndexN(
+		FoxMap * map,
+		const char * str,
+		size_t len
+);
+
+/**
+ * Equivalent to FoxStringMapIndexN(), but with a key hash previously obtained
+ * from FoxStringMapHash() (or FoxMapKeyHash()).
+ */
+void * FoxStringMapIndexHashed(
+		FoxMap * map,
+		const char * str,
+		size_t len,
+		uint64_t hash
+);
+
 
 
 #endif /* FOXUTILS_STRINGMAP_H */
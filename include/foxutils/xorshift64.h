@@ -50,6 +50,15 @@ void FoxXorshift64Seed(
 
 uint64_t FoxXorshift64Next(FoxXorshift64 * prng);
 
+/**
+ * Equivalent to num calls to FoxXorshift64Next(), storing the values in out.
+ */
+void FoxXorshift64Fill(
+		FoxXorshift64 * prng,
+		uint64_t * out,
+		size_t num
+);
+
 uint64_t FoxXorshift64Primitive(uint64_t * state);
 
 
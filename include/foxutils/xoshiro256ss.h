@@ -57,6 +57,15 @@ void FoxXoshiro256SSSeed(
 
 uint64_t FoxXoshiro256SSNext(FoxXoshiro256SS * prng);
 
+/**
+ * Equivalent to num calls to FoxXoshiro256SSNext(), storing the values in out.
+ */
+void FoxXoshiro256SSFill(
+		FoxXoshiro256SS * prng,
+		uint64_t * out,
+		size_t num
+);
+
 void FoxXoshiro256SSJump(
 		FoxXoshiro256SS * prng,
 		const uint64_t jumpPoly[4]
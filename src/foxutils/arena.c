@@ -0,0 +1,127 @@
+/*
+ * Copyright 2020 Garrett Russell Fairburn
+ * 
+ * This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "foxutils/arena.h"
+
+
+
+/* ----- PRIVATE TYPES ----- */
+
+typedef struct FoxArenaChunk {
+	struct FoxArenaChunk * prev;
+	max_align_t data[];
+} Chunk;
+
+
+
+/* ----- PRIVATE FUNCTIONS ----- */
+
+static Chunk * ChunkNew(size_t size) {
+	Chunk * chunk = malloc(sizeof(Chunk) + size);
+	assert(chunk);
+
+	return chunk;
+}
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+FoxArena * FoxArenaNew(size_t chunkSize) {
+	FoxArena * arena = malloc(sizeof(FoxArena));
+	assert(arena);
+	FoxArenaInit(arena, chunkSize);
+
+	return arena;
+}
+
+void FoxArenaFree(FoxArena * arena) {
+	FoxArenaDeinit(arena);
+	free(arena);
+
+	return;
+}
+
+void FoxArenaInit(
+		FoxArena * arena,
+		size_t chunkSize
+) {
+	assert(arena);
+	assert(chunkSize > 0);
+
+	*arena = (FoxArena){
+		.chunks = NULL,
+		.next = NULL,
+		.avail = 0,
+		.chunkSize = chunkSize
+	};
+
+	return;
+}
+
+void FoxArenaDeinit(FoxArena * arena) {
+	assert(arena);
+
+	Chunk * chunk = arena->chunks;
+	while (chunk) {
+		Chunk * prev = chunk->prev;
+		free(chunk);
+		chunk = prev;
+	}
+	*arena = (FoxArena){0};
+
+	return;
+}
+
+void * FoxArenaAlloc(
+		FoxArena * arena,
+		size_t size,
+		size_t align
+) {
+	assert(arena);
+	assert(align > 0 && (align & (align - 1)) == 0);
+	assert(align <= _Alignof(max_align_t));
+
+	size_t pad = -(uintptr_t)arena->next & (align - 1);
+	if (
+			!arena->next
+			|| arena->avail < size
+			|| arena->avail - size < pad
+	) {
+		Chunk * chunk;
+
+		/* Large allocations get a chunk of their own. */
+		if (size > arena->chunkSize / 4) {
+			chunk = ChunkNew(size);
+			if (arena->chunks) {
+				chunk->prev = arena->chunks->prev;
+				arena->chunks->prev = chunk;
+			} else {
+				chunk->prev = NULL;
+				arena->chunks = chunk;
+			}
+
+			return chunk->data;
+		}
+
+		chunk = ChunkNew(arena->chunkSize);
+		chunk->prev = arena->chunks;
+		arena->chunks = chunk;
+		arena->next = (unsigned char *)chunk->data;
+		arena->avail = arena->chunkSize;
+		pad = 0;
+	}
+
+	void * mem = arena->next + pad;
+	arena->next += pad + size;
+	arena->avail -= pad + size;
+
+	return mem;
+}
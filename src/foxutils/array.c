@@ -9,6 +9,7 @@
 #include <string.h>
 
 #include "foxutils/array.h"
+#include "foxutils/math.h"
 
 
 
@@ -85,6 +86,20 @@ void FoxArrayEnsureCapacity(
 	if (array->cap < cap) {
 		array->elems = realloc(array->elems, array->elemSize * cap);
 		assert(array->elems);
+		array->cap = cap;
+	}
+
+	return;
+}
+
+void FoxArrayShrink(FoxArray * array) {
+	assert(array);
+
+	size_t cap = FoxMax(array->size, 1ul);
+	if (array->cap > cap) {
+		array->elems = realloc(array->elems, array->elemSize * cap);
+		assert(array->elems);
+		array->cap = cap;
 	}
 
 	return;
@@ -92,7 +107,7 @@ void FoxArrayEnsureCapacity(
 
 void * FoxArrayIndex(
 		FoxArray * array,
-		unsigned int idx
+		size_t idx
 ) {
 	assert(array);
 	assert(idx < array->size);
@@ -110,7 +125,7 @@ void * FoxArrayPeek(FoxArray * array) {
 
 void * FoxArrayInsert(
 		FoxArray * array,
-		unsigned int idx
+		size_t idx
 ) {
 	assert(array);
 	assert(idx <= array->size);
@@ -149,7 +164,7 @@ void * FoxArrayPush(FoxArray * array) {
 
 void FoxArrayRemove(
 		FoxArray * array,
-		unsigned int idx,
+		size_t idx,
 		void * elem
 ) {
 	assert(array);
@@ -0,0 +1,369 @@
+/*
+ * Copyright 2020 Garrett Russell Fairburn
+ * 
+ * This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "foxutils/concurrentmap.h"
+#include "foxutils/math.h"
+
+
+
+/* ----- PRIVATE TYPES ----- */
+
+typedef struct ForEachCtx {
+	bool (* pairCallback)(const void *, void *, void *);
+	bool (* elemCallback)(void *, void *);
+	bool (* keyCallback)(const void *, void *);
+	void * ctx;
+	bool stopped;
+} ForEachCtx;
+
+
+
+/* ----- PRIVATE FUNCTIONS ----- */
+
+/*
+ * Every shard shares the first shard's hash key (see FoxConcurrentMapInit()),
+ * so a key is hashed once both to select its shard and to index it there.
+ */
+static inline uint64_t KeyHash(
+		FoxConcurrentMap * map,
+		const void * key
+) {
+	return FoxMapKeyHash(&map->shards->map, key);
+}
+
+/*
+ * Select a shard from the high bits of a key hash. The hash is remixed first
+ * because custom key hashes may leave their upper bits empty, and the shard
+ * maps themselves consume the low bits.
+ */
+static inline FoxConcurrentMapShard * HashShard(
+		FoxConcurrentMap * map,
+		uint64_t hash
+) {
+	uint64_t remixed = hash * 0x9e3779b97f4a7c15;
+
+	return map->shards + (size_t)(remixed >> 32 >> map->shardShift);
+}
+
+static bool PairCallback(
+		const void * key,
+		void * elem,
+		ForEachCtx * ctx
+) {
+	ctx->stopped = !ctx->pairCallback(key, elem, ctx->ctx);
+
+	return !ctx->stopped;
+}
+
+static bool ElementCallback(
+		void * elem,
+		ForEachCtx * ctx
+) {
+	ctx->stopped = !ctx->elemCallback(elem, ctx->ctx);
+
+	return !ctx->stopped;
+}
+
+static bool KeyCallback(
+		const void * key,
+		ForEachCtx * ctx
+) {
+	ctx->stopped = !ctx->keyCallback(key, ctx->ctx);
+
+	return !ctx->stopped;
+}
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+FoxConcurrentMap * FoxConcurrentMapNew(
+		size_t keySize,
+		size_t elemSize,
+		size_t numShards,
+		size_t initSlots,
+		float growRate,
+		float lfThresh,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void *, const void *),
+		void (* keyDeinit)(void *)
+) {
+	FoxConcurrentMap * map = calloc(1, sizeof(FoxConcurrentMap));
+	FoxConcurrentMapInit(
+			map,
+			keySize,
+			elemSize,
+			numShards,
+			initSlots,
+			growRate,
+			lfThresh,
+			keyHash,
+			keyCompare,
+			keyCopy,
+			keyDeinit
+	);
+
+	return map;
+}
+
+void FoxConcurrentMapFree(FoxConcurrentMap * map) {
+	FoxConcurrentMapDeinit(map);
+	free(map);
+
+	return;
+}
+
+void FoxConcurrentMapInit(
+		FoxConcurrentMap * map,
+		size_t keySize,
+		size_t elemSize,
+		size_t numShards,
+		size_t initSlots,
+		float growRate,
+		float lfThresh,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void *, const void *),
+		void (* keyDeinit)(void *)
+) {
+	assert(map);
+	assert(numShards > 0);
+	assert(numShards - 1 <= UINT32_MAX);
+
+	/* Calculate number of shards. */
+	numShards = FoxRoundUpPow2(numShards);
+	unsigned int shardBits = __builtin_ctzll(numShards);
+
+	/* Initialize scalar members. */
+	map->numShards = numShards;
+	map->shardShift = 32 - shardBits;
+	map->elemSize = elemSize;
+
+	/* Initialize shards. */
+	map->shards = aligned_alloc(
+			_Alignof(FoxConcurrentMapShard),
+			sizeof(FoxConcurrentMapShard) * numShards
+	);
+	assert(map->shards);
+	for (size_t idx = 0; idx < numShards; idx++) {
+		FoxConcurrentMapShard * shard = map->shards + idx;
+		int err = pthread_rwlock_init(&shard->lock, NULL);
+		assert(err == 0);
+		(void)err;
+		FoxMapInit64(
+				&shard->map,
+				keySize,
+				elemSize,
+				FoxMax(initSlots / numShards, 1ul),
+				growRate,
+				lfThresh,
+				keyHash,
+				keyCompare,
+				keyCopy,
+				keyDeinit
+		);
+		shard->map.hashKey = map->shards->map.hashKey;
+	}
+
+	return;
+}
+
+void FoxConcurrentMapDeinit(FoxConcurrentMap * map) {
+	assert(map);
+
+	size_t numShards = map->numShards;
+	for (size_t idx = 0; idx < numShards; idx++) {
+		FoxConcurrentMapShard * shard = map->shards + idx;
+		FoxMapDeinit(&shard->map);
+		pthread_rwlock_destroy(&shard->lock);
+	}
+	free(map->shards);
+	*map = (FoxConcurrentMap){0};
+
+	return;
+}
+
+size_t FoxConcurrentMapSize(FoxConcurrentMap * map) {
+	assert(map);
+
+	size_t size = 0;
+	size_t numShards = map->numShards;
+	for (size_t idx = 0; idx < numShards; idx++) {
+		FoxConcurrentMapShard * shard = map->shards + idx;
+		pthread_rwlock_rdlock(&shard->lock);
+		size += FoxMapSize(&shard->map);
+		pthread_rwlock_unlock(&shard->lock);
+	}
+
+	return size;
+}
+
+bool FoxConcurrentMapIndex(
+		FoxConcurrentMap * map,
+		const void * key,
+		void * elem
+) {
+	assert(map);
+	assert(key);
+	assert(elem);
+
+	uint64_t hash = KeyHash(map, key);
+	FoxConcurrentMapShard * shard = HashShard(map, hash);
+
+	/* Lookups under the read lock must not migrate slots. */
+	pthread_rwlock_rdlock(&shard->lock);
+	void * found = FoxMapFindHashed(&shard->map, key, hash);
+	if (found) memcpy(elem, found, map->elemSize);
+	pthread_rwlock_unlock(&shard->lock);
+
+	return found != NULL;
+}
+
+bool FoxConcurrentMapInsert(
+		FoxConcurrentMap * map,
+		const void * key,
+		const void * elem
+) {
+	assert(map);
+	assert(key);
+	assert(elem);
+
+	uint64_t hash = KeyHash(map, key);
+	FoxConcurrentMapShard * shard = HashShard(map, hash);
+
+	pthread_rwlock_wrlock(&shard->lock);
+	bool inserted = !FoxMapIndexHashed(&shard->map, key, hash);
+	if (inserted) {
+		memcpy(
+				FoxMapInsertHashed(&shard->map, key, hash),
+				elem,
+				map->elemSize
+		);
+	}
+	pthread_rwlock_unlock(&shard->lock);
+
+	return inserted;
+}
+
+void FoxConcurrentMapUpsert(
+		FoxConcurrentMap * map,
+		const void * key,
+		void (* callback)(void * elem, bool inserted, void * ctx),
+		void * ctx
+) {
+	assert(map);
+	assert(key);
+	assert(callback);
+
+	uint64_t hash = KeyHash(map, key);
+	FoxConcurrentMapShard * shard = HashShard(map, hash);
+
+	pthread_rwlock_wrlock(&shard->lock);
+	void * elem = FoxMapIndexHashed(&shard->map, key, hash);
+	bool inserted = !elem;
+	if (inserted) elem = FoxMapInsertHashed(&shard->map, key, hash);
+	callback(elem, inserted, ctx);
+	pthread_rwlock_unlock(&shard->lock);
+
+	return;
+}
+
+bool FoxConcurrentMapRemove(
+		FoxConcurrentMap * map,
+		const void * key,
+		void * elem
+) {
+	assert(map);
+	assert(key);
+
+	uint64_t hash = KeyHash(map, key);
+	FoxConcurrentMapShard * shard = HashShard(map, hash);
+
+	pthread_rwlock_wrlock(&shard->lock);
+	bool removed = FoxMapIndexHashed(&shard->map, key, hash) != NULL;
+	if (removed) FoxMapRemoveHashed(&shard->map, key, hash, elem);
+	pthread_rwlock_unlock(&shard->lock);
+
+	return removed;
+}
+
+void FoxConcurrentMapForEachPair(
+		FoxConcurrentMap * map,
+		bool (* callback)(const void * key, void * elem, void * ctx),
+		void * ctx
+) {
+	assert(map);
+	assert(callback);
+
+	ForEachCtx forEachCtx = {.pairCallback = callback, .ctx = ctx};
+	size_t numShards = map->numShards;
+	for (size_t idx = 0; idx < numShards && !forEachCtx.stopped; idx++) {
+		FoxConcurrentMapShard * shard = map->shards + idx;
+		pthread_rwlock_wrlock(&shard->lock);
+		FoxMapForEachPair(
+				&shard->map,
+				(bool (*)(const void *, void *, void *))&PairCallback,
+				&forEachCtx
+		);
+		pthread_rwlock_unlock(&shard->lock);
+	}
+
+	return;
+}
+
+void FoxConcurrentMapForEachElement(
+		FoxConcurrentMap * map,
+		bool (* callback)(void * elem, void * ctx),
+		void * ctx
+) {
+	assert(map);
+	assert(callback);
+
+	ForEachCtx forEachCtx = {.elemCallback = callback, .ctx = ctx};
+	size_t numShards = map->numShards;
+	for (size_t idx = 0; idx < numShards && !forEachCtx.stopped; idx++) {
+		FoxConcurrentMapShard * shard = map->shards + idx;
+		pthread_rwlock_wrlock(&shard->lock);
+		FoxMapForEachElement(
+				&shard->map,
+				(bool (*)(void *, void *))&ElementCallback,
+				&forEachCtx
+		);
+		pthread_rwlock_unlock(&shard->lock);
+	}
+
+	return;
+}
+
+void FoxConcurrentMapForEachKey(
+		FoxConcurrentMap * map,
+		bool (* callback)(const void * key, void * ctx),
+		void * ctx
+) {
+	assert(map);
+	assert(callback);
+
+	ForEachCtx forEachCtx = {.keyCallback = callback, .ctx = ctx};
+	size_t numShards = map->numShards;
+	for (size_t idx = 0; idx < numShards && !forEachCtx.stopped; idx++) {
+		FoxConcurrentMapShard * shard = map->shards + idx;
+		pthread_rwlock_rdlock(&shard->lock);
+		FoxMapForEachKey(
+				&shard->map,
+				(bool (*)(const void *, void *))&KeyCallback,
+				&forEachCtx
+		);
+		pthread_rwlock_unlock(&shard->lock);
+	}
+
+	return;
+}
@@ -0,0 +1,478 @@
+/*
+ * Copyright 2020 Garrett Russell Fairburn
+ * 
+ * This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "foxutils/flatmap.h"
+#include "foxutils/hash.h"
+#include "foxutils/math.h"
+
+
+
+/* ----- PRIVATE MACROS ----- */
+
+#define CTRL_EMPTY 0x80
+
+#define CTRL_DELETED 0xfe
+
+#define CTRL_LSBS 0x0101010101010101ull
+
+#define CTRL_MSBS 0x8080808080808080ull
+
+#define SLOT_ALIGN 8ul
+
+#define SlotKey(map, idx) ((map)->slots + (map)->slotSize * (idx))
+
+#define SlotElem(map, idx) (SlotKey((map), (idx)) + (map)->elemOffset)
+
+#define Fingerprint(hash) ((uint8_t)((hash) & 0x7f))
+
+#define MaxLoad(numSlots) ((numSlots) - (numSlots) / 8)
+
+
+
+/* ----- PRIVATE FUNCTIONS ----- */
+
+static inline size_t AlignUp(size_t val) {
+	return (val + SLOT_ALIGN - 1) & ~(SLOT_ALIGN - 1);
+}
+
+/*
+ * Load 8 control bytes such that the first byte occupies the least
+ * significant bits of the result.
+ */
+static inline uint64_t LoadCtrl(const unsigned char * ctrl) {
+	uint64_t word;
+	memcpy(&word, ctrl, sizeof(uint64_t));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	word = __builtin_bswap64(word);
+#endif
+
+	return word;
+}
+
+/*
+ * Match control bytes equal to a fingerprint. May report false positives
+ * (only ever on full slots), but never false negatives.
+ */
+static inline uint64_t MatchFingerprint(uint64_t word, uint8_t fingerprint) {
+	uint64_t cmp = word ^ (CTRL_LSBS * fingerprint);
+
+	return (cmp - CTRL_LSBS) & ~cmp & CTRL_MSBS;
+}
+
+static inline uint64_t MatchEmpty(uint64_t word) {
+	return word & ~(word << 6) & CTRL_MSBS;
+}
+
+static inline uint64_t MatchEmptyOrDeleted(uint64_t word) {
+	return word & CTRL_MSBS;
+}
+
+static inline uint64_t MatchFull(uint64_t word) {
+	return ~word & CTRL_MSBS;
+}
+
+static inline size_t MatchIdx(uint64_t match) {
+	return (size_t)__builtin_ctzll(match) >> 3;
+}
+
+static inline uint64_t KeyHash(
+		FoxFlatMap * map,
+		const void * key
+) {
+	uint64_t (* keyHash)(const void *) = map->keyHash;
+	if (keyHash) return keyHash(key);
+
+	return FoxHashKeySeeded(key, map->keySize, 0);
+}
+
+static inline bool KeyEqual(
+		FoxFlatMap * map,
+		const void * key,
+		const void * slotKey
+) {
+	int (* keyCompare)(const void *, const void *) = map->keyCompare;
+
+	return (
+			(keyCompare) ?
+			keyCompare(key, slotKey)
+			: memcmp(key, slotKey, map->keySize)
+	) == 0;
+}
+
+static inline bool SlotLookup(
+		FoxFlatMap * map,
+		const void * key,
+		uint64_t hash,
+		size_t * slotIdx
+) {
+	const unsigned char * ctrl = map->ctrl;
+	uint8_t fingerprint = Fingerprint(hash);
+	size_t groupMask = map->numSlots / FOXFLATMAP_GROUP_WIDTH - 1;
+	size_t groupIdx = (hash >> 7) & groupMask;
+
+	/* Probe groups triangularly until one containing an empty slot. */
+	for (size_t probe = 1; ; probe++) {
+		bool sawEmpty = false;
+		for (size_t half = 0; half < FOXFLATMAP_GROUP_WIDTH; half += 8) {
+			size_t base = groupIdx * FOXFLATMAP_GROUP_WIDTH + half;
+			uint64_t word = LoadCtrl(ctrl + base);
+			for (
+					uint64_t match = MatchFingerprint(word, fingerprint);
+					match;
+					match &= match - 1
+			) {
+				size_t idx = base + MatchIdx(match);
+				if (KeyEqual(map, key, SlotKey(map, idx))) {
+					*slotIdx = idx;
+					return true;
+				}
+			}
+			sawEmpty |= MatchEmpty(word) != 0;
+		}
+		if (sawEmpty) break;
+		groupIdx = (groupIdx + probe) & groupMask;
+	}
+
+	return false;
+}
+
+static inline size_t FindInsertSlot(
+		FoxFlatMap * map,
+		uint64_t hash
+) {
+	const unsigned char * ctrl = map->ctrl;
+	size_t groupMask = map->numSlots / FOXFLATMAP_GROUP_WIDTH - 1;
+	size_t groupIdx = (hash >> 7) & groupMask;
+
+	for (size_t probe = 1; ; probe++) {
+		for (size_t half = 0; half < FOXFLATMAP_GROUP_WIDTH; half += 8) {
+			size_t base = groupIdx * FOXFLATMAP_GROUP_WIDTH + half;
+			uint64_t match = MatchEmptyOrDeleted(LoadCtrl(ctrl + base));
+			if (match) return base + MatchIdx(match);
+		}
+		groupIdx = (groupIdx + probe) & groupMask;
+	}
+}
+
+static void AllocSlots(
+		FoxFlatMap * map,
+		size_t numSlots
+) {
+	map->ctrl = malloc(numSlots + map->slotSize * numSlots);
+	assert(map->ctrl);
+	map->slots = map->ctrl + numSlots;
+	memset(map->ctrl, CTRL_EMPTY, numSlots);
+	map->numSlots = numSlots;
+	map->growthLeft = MaxLoad(numSlots) - map->size;
+
+	return;
+}
+
+static void Rehash(
+		FoxFlatMap * map,
+		size_t numSlots
+) {
+	FoxFlatMap old = *map;
+
+	/* Move full slots into fresh storage without re-copying keys. */
+	AllocSlots(map, numSlots);
+	for (size_t base = 0; base < old.numSlots; base += 8) {
+		for (
+				uint64_t match = MatchFull(LoadCtrl(old.ctrl + base));
+				match;
+				match &= match - 1
+		) {
+			size_t oldIdx = base + MatchIdx(match);
+			void * oldKey = SlotKey(&old, oldIdx);
+			uint64_t hash = KeyHash(map, oldKey);
+			size_t idx = FindInsertSlot(map, hash);
+			map->ctrl[idx] = Fingerprint(hash);
+			memcpy(SlotKey(map, idx), oldKey, map->slotSize);
+		}
+	}
+	free(old.ctrl);
+
+	return;
+}
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+FoxFlatMap * FoxFlatMapNew(
+		size_t keySize,
+		size_t elemSize,
+		size_t initSlots,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void *, const void *),
+		void (* keyDeinit)(void *)
+) {
+	FoxFlatMap * map = calloc(1, sizeof(FoxFlatMap));
+	FoxFlatMapInit(
+			map,
+			keySize,
+			elemSize,
+			initSlots,
+			keyHash,
+			keyCompare,
+			keyCopy,
+			keyDeinit
+	);
+
+	return map;
+}
+
+void FoxFlatMapFree(FoxFlatMap * map) {
+	FoxFlatMapDeinit(map);
+	free(map);
+
+	return;
+}
+
+void FoxFlatMapInit(
+		FoxFlatMap * map,
+		size_t keySize,
+		size_t elemSize,
+		size_t initSlots,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void *, const void *),
+		void (* keyDeinit)(void *)
+) {
+	assert(map);
+	assert(keySize > 0);
+	assert(elemSize > 0);
+	assert(initSlots <= (1ul << (sizeof(size_t) * 8 - 1)));
+
+	/* Initialize scalar members. */
+	map->keySize = keySize;
+	map->elemSize = elemSize;
+	map->elemOffset = AlignUp(keySize);
+	map->slotSize = AlignUp(map->elemOffset + elemSize);
+	map->size = 0;
+
+	/* Initialize key functions. */
+	map->keyHash = keyHash;
+	map->keyCompare = keyCompare;
+	map->keyCopy = keyCopy;
+	map->keyDeinit = keyDeinit;
+
+	/* Initialize slots. */
+	AllocSlots(
+			map,
+			FoxMax(FoxRoundUpPow2(initSlots), FOXFLATMAP_GROUP_WIDTH)
+	);
+
+	return;
+}
+
+void FoxFlatMapDeinit(FoxFlatMap * map) {
+	assert(map);
+
+	void (* keyDeinit)(void *) = map->keyDeinit;
+	if (keyDeinit) {
+		for (size_t base = 0; base < map->numSlots; base += 8) {
+			for (
+					uint64_t match = MatchFull(LoadCtrl(map->ctrl + base));
+					match;
+					match &= match - 1
+			) {
+				keyDeinit(SlotKey(map, base + MatchIdx(match)));
+			}
+		}
+	}
+	free(map->ctrl);
+	*map = (FoxFlatMap){0};
+
+	return;
+}
+
+size_t FoxFlatMapSize(FoxFlatMap * map) {
+	assert(map);
+
+	return map->size;
+}
+
+bool FoxFlatMapEmpty(FoxFlatMap * map) {
+	assert(map);
+
+	return map->size == 0;
+}
+
+float FoxFlatMapLoadFactor(FoxFlatMap * map) {
+	assert(map);
+
+	return (float)map->size / (float)map->numSlots;
+}
+
+void * FoxFlatMapIndex(
+		FoxFlatMap * map,
+		const void * key
+) {
+	assert(map);
+	assert(key);
+
+	size_t slotIdx;
+	if (!SlotLookup(map, key, KeyHash(map, key), &slotIdx)) return NULL;
+
+	return SlotElem(map, slotIdx);
+}
+
+void * FoxFlatMapInsert(
+		FoxFlatMap * map,
+		const void * key
+) {
+	assert(map);
+	assert(key);
+
+	uint64_t hash = KeyHash(map, key);
+	size_t slotIdx;
+	assert(!SlotLookup(map, key, hash, &slotIdx));
+
+	/* Grow (or purge deleted slots from) map if necessary. */
+	slotIdx = FindInsertSlot(map, hash);
+	if (map->growthLeft == 0 && map->ctrl[slotIdx] == CTRL_EMPTY) {
+		size_t numSlots = map->numSlots;
+		Rehash(
+				map,
+				(map->size > MaxLoad(numSlots) / 2) ? numSlots * 2 : numSlots
+		);
+		slotIdx = FindInsertSlot(map, hash);
+	}
+
+	/* Claim slot. */
+	map->growthLeft -= (map->ctrl[slotIdx] == CTRL_EMPTY);
+	map->ctrl[slotIdx] = Fingerprint(hash);
+	map->size++;
+
+	/* Copy key. */
+	void * slotKey = SlotKey(map, slotIdx);
+	void (* keyCopy)(void *, const void *) = map->keyCopy;
+	if (keyCopy) {
+		keyCopy(slotKey, key);
+	} else {
+		memcpy(slotKey, key, map->keySize);
+	}
+
+	/* Initialize target element. */
+	void * elem = SlotElem(map, slotIdx);
+	memset(elem, 0, map->elemSize);
+
+	return elem;
+}
+
+void FoxFlatMapRemove(
+		FoxFlatMap * map,
+		const void * key,
+		void * elem
+) {
+	assert(map);
+	assert(key);
+
+	size_t slotIdx;
+	bool exists = SlotLookup(map, key, KeyHash(map, key), &slotIdx);
+	assert(exists);
+	(void)exists;
+
+	/* Copy target element if requested. */
+	if (elem) memcpy(elem, SlotElem(map, slotIdx), map->elemSize);
+
+	/* De-initialize key. */
+	void (* keyDeinit)(void *) = map->keyDeinit;
+	if (keyDeinit) keyDeinit(SlotKey(map, slotIdx));
+
+	/*
+	 * A group which still contains an empty slot has never been full, so no
+	 * probe sequence has ever passed through it and the slot can be emptied
+	 * outright rather than marked as deleted.
+	 */
+	size_t base = slotIdx & ~(FOXFLATMAP_GROUP_WIDTH - 1);
+	bool groupHasEmpty = (
+			MatchEmpty(LoadCtrl(map->ctrl + base))
+			| MatchEmpty(LoadCtrl(map->ctrl + base + 8))
+	) != 0;
+	if (groupHasEmpty) {
+		map->ctrl[slotIdx] = CTRL_EMPTY;
+		map->growthLeft++;
+	} else {
+		map->ctrl[slotIdx] = CTRL_DELETED;
+	}
+	map->size--;
+
+	return;
+}
+
+void FoxFlatMapForEachPair(
+		FoxFlatMap * map,
+		bool (* callback)(const void * key, void * elem, void * ctx),
+		void * ctx
+) {
+	assert(map);
+	assert(callback);
+
+	size_t numSlots = map->numSlots;
+	for (size_t base = 0; base < numSlots; base += 8) {
+		for (
+				uint64_t match = MatchFull(LoadCtrl(map->ctrl + base));
+				match;
+				match &= match - 1
+		) {
+			size_t idx = base + MatchIdx(match);
+			if (!callback(SlotKey(map, idx), SlotElem(map, idx), ctx)) return;
+		}
+	}
+
+	return;
+}
+
+void FoxFlatMapForEachElement(
+		FoxFlatMap * map,
+		bool (* callback)(void * elem, void * ctx),
+		void * ctx
+) {
+	assert(map);
+	assert(callback);
+
+	size_t numSlots = map->numSlots;
+	for (size_t base = 0; base < numSlots; base += 8) {
+		for (
+				uint64_t match = MatchFull(LoadCtrl(map->ctrl + base));
+				match;
+				match &= match - 1
+		) {
+			if (!callback(SlotElem(map, base + MatchIdx(match)), ctx)) return;
+		}
+	}
+
+	return;
+}
+
+void FoxFlatMapForEachKey(
+		FoxFlatMap * map,
+		bool (* callback)(const void * key, void * ctx),
+		void * ctx
+) {
+	assert(map);
+	assert(callback);
+
+	size_t numSlots = map->numSlots;
+	for (size_t base = 0; base < numSlots; base += 8) {
+		for (
+				uint64_t match = MatchFull(LoadCtrl(map->ctrl + base));
+				match;
+				match &= match - 1
+		) {
+			if (!callback(SlotKey(map, base + MatchIdx(match)), ctx)) return;
+		}
+	}
+
+	return;
+}
@@ -0,0 +1,683 @@
+/*
+ * Copyright 2020 Garrett Russell Fairburn
+ * 
+ * This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ */
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "foxutils/frozenmap.h"
+#include "foxutils/hash.h"
+#include "foxutils/math.h"
+
+
+
+/* ----- PRIVATE MACROS ----- */
+
+#define PARTITION_KEYS 4096ul
+
+#define BUCKET_KEYS 4ul
+
+#define MAX_THREADS 64l
+
+#define ENTRY_ALIGN 8ul
+
+#define PARTITION_SEED 0x9e3779b97f4a7c15ull
+
+#define BUCKET_SEED 0xc2b2ae3d27d4eb4full
+
+#define PILOT_SEED 0x165667b19e3779f9ull
+
+/* Pilots tried for each bucket before giving up on a partition. */
+#define MAX_PILOTS (1ul << 24)
+
+#define AlignUp(size) (((size) + ENTRY_ALIGN - 1) & ~(ENTRY_ALIGN - 1))
+
+#define EntryKey(entry) ((void *)((entry) + sizeof(uint64_t)))
+
+#define EntryElem(frozen, entry) \
+	((void *)((entry) + sizeof(uint64_t) + AlignUp((frozen)->keySize)))
+
+
+
+/* ----- PRIVATE TYPES ----- */
+
+typedef struct FoxFrozenMapPartition {
+	size_t entryOffset;
+	size_t numKeys;
+	size_t pilotOffset;
+	size_t numBuckets;
+} Partition;
+
+typedef struct Pair {
+	uint64_t hash;
+	const void * key;
+	const void * elem;
+	bool overflow;
+} Pair;
+
+typedef struct Build {
+	FoxFrozenMap * frozen;
+	Partition * partitions;
+	uint32_t * pilots;
+	Pair * pairs; /* Grouped by partition. */
+	size_t * positions; /* Final entry index of each pair. */
+	void (* keyCopy)(void *, const void *);
+	bool (* buildPartition)(struct Build *, size_t);
+	atomic_size_t nextPartition;
+	atomic_bool failed;
+} Build;
+
+typedef struct CollectCtx {
+	FoxMap * map;
+	Pair * pairs;
+	size_t numPairs;
+} CollectCtx;
+
+
+
+/* ----- PRIVATE FUNCTIONS ----- */
+
+static inline uint64_t Mix(uint64_t val) {
+	val ^= val >> 30;
+	val *= 0xbf58476d1ce4e5b9ull;
+	val ^= val >> 27;
+	val *= 0x94d049bb133111ebull;
+	val ^= val >> 31;
+
+	return val;
+}
+
+/*
+ * Map a uniformly distributed hash onto [0, range) without division (by
+ * taking the upper half of their 128-bit product).
+ */
+static inline size_t FastRange(
+		uint64_t hash,
+		size_t range
+) {
+#ifdef __SIZEOF_INT128__
+	return (size_t)(((unsigned __int128)hash * range) >> 64);
+#else
+	uint64_t hashLo = hash & 0xffffffffull;
+	uint64_t hashHi = hash >> 32;
+	uint64_t rangeLo = (uint64_t)range & 0xffffffffull;
+	uint64_t rangeHi = (uint64_t)range >> 32;
+
+	uint64_t lo = hashLo * rangeLo;
+	uint64_t mid = hashHi * rangeLo + (lo >> 32);
+	uint64_t mid2 = hashLo * rangeHi + (mid & 0xffffffffull);
+
+	return (size_t)(hashHi * rangeHi + (mid >> 32) + (mid2 >> 32));
+#endif
+}
+
+static inline size_t PartitionIdx(
+		uint64_t hash,
+		size_t numPartitions
+) {
+	return FastRange(Mix(hash ^ PARTITION_SEED), numPartitions);
+}
+
+static inline size_t BucketIdx(
+		uint64_t hash,
+		size_t numBuckets
+) {
+	return FastRange(Mix(hash ^ BUCKET_SEED), numBuckets);
+}
+
+static inline size_t PilotPosition(
+		uint64_t hash,
+		uint32_t pilot,
+		size_t numKeys
+) {
+	return FastRange(Mix(hash ^ Mix(pilot + PILOT_SEED)), numKeys);
+}
+
+/*
+ * Hash a key exactly as the original map did (see FoxMapKeyHash()).
+ */
+static inline uint64_t KeyHash(
+		FoxFrozenMap * frozen,
+		const void * key
+) {
+	if (frozen->keyedHash) {
+		uint64_t (* keyHashKeyed)(const void *, const FoxHashKey *) = (
+				frozen->keyHashKeyed
+		);
+		if (keyHashKeyed) return keyHashKeyed(key, &frozen->hashKey);
+
+		return FoxHashMemKeyed(key, frozen->keySize, &frozen->hashKey);
+	}
+
+	uint64_t (* keyHashSeeded)(const void *, uint64_t) = (
+			frozen->keyHashSeeded
+	);
+	uint64_t (* keyHash64)(const void *) = frozen->keyHash64;
+	unsigned int (* keyHash)(const void *) = frozen->keyHash;
+
+	if (keyHashSeeded) return keyHashSeeded(key, frozen->hashKey.k0);
+	if (keyHash64) return keyHash64(key);
+	if (keyHash) return keyHash(key);
+
+	return FoxHashKeySeeded(key, frozen->keySize, frozen->hashKey.k0);
+}
+
+static inline bool KeyEqual(
+		FoxFrozenMap * frozen,
+		const void * keyA,
+		const void * keyB
+) {
+	int (* keyCompare)(const void *, const void *) = frozen->keyCompare;
+	int diff = (
+			(keyCompare) ?
+			keyCompare(keyA, keyB)
+			: memcmp(keyA, keyB, frozen->keySize)
+	);
+
+	return diff == 0;
+}
+
+static const void * OverflowIndex(
+		FoxFrozenMap * frozen,
+		const void * key,
+		uint64_t hash
+) {
+	size_t entrySize = frozen->entrySize;
+
+	/* Find the first overflow entry with the hash. */
+	size_t lo = 0;
+	size_t hi = frozen->numOverflow;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (*(uint64_t *)(frozen->overflow + mid * entrySize) < hash) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	for (; lo < frozen->numOverflow; lo++) {
+		unsigned char * entry = frozen->overflow + lo * entrySize;
+		if (*(uint64_t *)entry != hash) break;
+		if (KeyEqual(frozen, key, EntryKey(entry))) {
+			return EntryElem(frozen, entry);
+		}
+	}
+
+	return NULL;
+}
+
+static int PairCompareHash(
+		const Pair * pairA,
+		const Pair * pairB
+) {
+	return (pairA->hash > pairB->hash) - (pairA->hash < pairB->hash);
+}
+
+static bool CollectPair(
+		const void * key,
+		void * elem,
+		CollectCtx * ctx
+) {
+	ctx->pairs[ctx->numPairs++] = (Pair){
+		.hash = FoxMapKeyHash(ctx->map, key),
+		.key = key,
+		.elem = elem,
+		.overflow = false
+	};
+
+	return true;
+}
+
+static void WriteEntry(
+		Build * build,
+		unsigned char * entry,
+		const Pair * pair
+) {
+	FoxFrozenMap * frozen = build->frozen;
+	void (* keyCopy)(void *, const void *) = build->keyCopy;
+
+	*(uint64_t *)entry = pair->hash;
+	if (keyCopy) {
+		keyCopy(EntryKey(entry), pair->key);
+	} else {
+		memcpy(EntryKey(entry), pair->key, frozen->keySize);
+	}
+	memcpy(EntryElem(frozen, entry), pair->elem, frozen->elemSize);
+
+	return;
+}
+
+/*
+ * Flag every pair of a partition whose hash was already seen, as no pilot
+ * can separate keys whose hashes are identical.
+ */
+static bool FlagOverflow(
+		Build * build,
+		size_t partitionIdx
+) {
+	Partition * partition = build->partitions + partitionIdx;
+	size_t numKeys = partition->numKeys;
+	Pair * pairs = build->pairs + partition->entryOffset;
+	if (numKeys < 2) return true;
+
+	size_t slotIdxMask = FoxRoundUpMersenne(numKeys * 2 - 1);
+	size_t * slots = malloc((slotIdxMask + 1) * sizeof(size_t));
+	assert(slots);
+	memset(slots, 0xff, (slotIdxMask + 1) * sizeof(size_t));
+	for (size_t idx = 0; idx < numKeys; idx++) {
+		uint64_t hash = pairs[idx].hash;
+		size_t slotIdx = Mix(hash) & slotIdxMask;
+		while (slots[slotIdx] != SIZE_MAX) {
+			if (pairs[slots[slotIdx]].hash == hash) {
+				pairs[idx].overflow = true;
+				break;
+			}
+			slotIdx = (slotIdx + 1) & slotIdxMask;
+		}
+		if (!pairs[idx].overflow) slots[slotIdx] = idx;
+	}
+	free(slots);
+
+	return true;
+}
+
+/*
+ * Find a pilot for every bucket of a partition, largest buckets first, such
+ * that the partition's keys land on distinct positions.
+ */
+static bool SearchPilots(
+		Build * build,
+		size_t partitionIdx
+) {
+	Partition * partition = build->partitions + partitionIdx;
+	size_t numKeys = partition->numKeys;
+	size_t numBuckets = partition->numBuckets;
+	Pair * pairs = build->pairs + partition->entryOffset;
+	size_t * positions = build->positions + partition->entryOffset;
+	uint32_t * pilots = build->pilots + partition->pilotOffset;
+	memset(pilots, 0, numBuckets * sizeof(uint32_t));
+	if (numKeys == 0) return true;
+
+	/* Group pairs by bucket. */
+	size_t * bucketStarts = calloc(numBuckets + 1, sizeof(size_t));
+	size_t * order = malloc(numKeys * sizeof(size_t));
+	assert(bucketStarts);
+	assert(order);
+	for (size_t idx = 0; idx < numKeys; idx++) {
+		bucketStarts[BucketIdx(pairs[idx].hash, numBuckets) + 1]++;
+	}
+	size_t maxBucketSize = 0;
+	for (size_t idx = 0; idx < numBuckets; idx++) {
+		maxBucketSize = FoxMax(maxBucketSize, bucketStarts[idx + 1]);
+		bucketStarts[idx + 1] += bucketStarts[idx];
+	}
+	size_t * bucketEnds = malloc(numBuckets * sizeof(size_t));
+	assert(bucketEnds);
+	memcpy(bucketEnds, bucketStarts, numBuckets * sizeof(size_t));
+	for (size_t idx = 0; idx < numKeys; idx++) {
+		order[bucketEnds[BucketIdx(pairs[idx].hash, numBuckets)]++] = idx;
+	}
+
+	/* Order buckets from largest to smallest. */
+	size_t * sizeStarts = calloc(maxBucketSize + 2, sizeof(size_t));
+	size_t * buckets = malloc(numBuckets * sizeof(size_t));
+	assert(sizeStarts);
+	assert(buckets);
+	for (size_t idx = 0; idx < numBuckets; idx++) {
+		size_t bucketSize = bucketStarts[idx + 1] - bucketStarts[idx];
+		sizeStarts[maxBucketSize - bucketSize + 1]++;
+	}
+	for (size_t idx = 0; idx <= maxBucketSize; idx++) {
+		sizeStarts[idx + 1] += sizeStarts[idx];
+	}
+	for (size_t idx = 0; idx < numBuckets; idx++) {
+		size_t bucketSize = bucketStarts[idx + 1] - bucketStarts[idx];
+		buckets[sizeStarts[maxBucketSize - bucketSize]++] = idx;
+	}
+
+	/* Search pilots. */
+	bool success = true;
+	bool * taken = calloc(numKeys, sizeof(bool));
+	assert(taken);
+	for (size_t bucketIdx = 0; bucketIdx < numBuckets && success; bucketIdx++) {
+		size_t bucket = buckets[bucketIdx];
+		size_t * bucketPairs = order + bucketStarts[bucket];
+		size_t bucketSize = bucketStarts[bucket + 1] - bucketStarts[bucket];
+		if (bucketSize == 0) break;
+
+		success = false;
+		for (uint32_t pilot = 0; pilot < MAX_PILOTS; pilot++) {
+			size_t numPlaced = 0;
+			for (; numPlaced < bucketSize; numPlaced++) {
+				size_t pairIdx = bucketPairs[numPlaced];
+				size_t pos = PilotPosition(pairs[pairIdx].hash, pilot, numKeys);
+				if (taken[pos]) break;
+				taken[pos] = true;
+				positions[pairIdx] = pos;
+			}
+			if (numPlaced == bucketSize) {
+				pilots[bucket] = pilot;
+				success = true;
+				break;
+			}
+			while (numPlaced > 0) {
+				taken[positions[bucketPairs[--numPlaced]]] = false;
+			}
+		}
+	}
+
+	free(taken);
+	free(buckets);
+	free(sizeStarts);
+	free(bucketEnds);
+	free(order);
+	free(bucketStarts);
+
+	return success;
+}
+
+static bool CopyEntries(
+		Build * build,
+		size_t partitionIdx
+) {
+	FoxFrozenMap * frozen = build->frozen;
+	Partition * partition = build->partitions + partitionIdx;
+	size_t entryOffset = partition->entryOffset;
+
+	for (size_t idx = 0; idx < partition->numKeys; idx++) {
+		unsigned char * entry = frozen->entries
+			+ (entryOffset + build->positions[entryOffset + idx])
+			* frozen->entrySize;
+		WriteEntry(build, entry, build->pairs + entryOffset + idx);
+	}
+
+	return true;
+}
+
+static void * BuildWorker(Build * build) {
+	size_t numPartitions = build->frozen->numPartitions;
+	while (!atomic_load(&build->failed)) {
+		size_t partitionIdx = atomic_fetch_add(&build->nextPartition, 1);
+		if (partitionIdx >= numPartitions) break;
+		if (!build->buildPartition(build, partitionIdx)) {
+			atomic_store(&build->failed, true);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Run a build step over every partition using a pool of threads (including
+ * the calling thread).
+ */
+static bool BuildParallel(
+		Build * build,
+		bool (* buildPartition)(Build *, size_t)
+) {
+	pthread_t threads[MAX_THREADS];
+	long numThreads = FoxMin(sysconf(_SC_NPROCESSORS_ONLN), MAX_THREADS);
+	numThreads = FoxMin(numThreads, (long)build->frozen->numPartitions);
+
+	build->buildPartition = buildPartition;
+	atomic_store(&build->nextPartition, 0);
+	long numSpawned = 0;
+	for (; numSpawned < numThreads - 1; numSpawned++) {
+		int err = pthread_create(
+				threads + numSpawned,
+				NULL,
+				(void * (*)(void *))&BuildWorker,
+				build
+		);
+		if (err != 0) break;
+	}
+	BuildWorker(build);
+	for (long idx = 0; idx < numSpawned; idx++) {
+		pthread_join(threads[idx], NULL);
+	}
+
+	return !atomic_load(&build->failed);
+}
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+FoxFrozenMap * FoxMapFreeze(FoxMap * map) {
+	FoxFrozenMap * frozen = calloc(1, sizeof(FoxFrozenMap));
+	assert(frozen);
+	if (!FoxFrozenMapInit(frozen, map)) {
+		free(frozen);
+		return NULL;
+	}
+
+	return frozen;
+}
+
+void FoxFrozenMapFree(FoxFrozenMap * frozen) {
+	FoxFrozenMapDeinit(frozen);
+	free(frozen);
+
+	return;
+}
+
+bool FoxFrozenMapInit(
+		FoxFrozenMap * frozen,
+		FoxMap * map
+) {
+	assert(frozen);
+	assert(map);
+	size_t numKeys = FoxMapSize(map);
+
+	/*
+	 * Initialize scalar members. Keys copied bytewise still belong to the map,
+	 * so they are only de-initialized if the frozen map made its own copies.
+	 */
+	*frozen = (FoxFrozenMap){
+		.size = numKeys,
+		.keyHash = map->keyHash,
+		.keyHash64 = map->keyHash64,
+		.keyHashSeeded = map->keyHashSeeded,
+		.keyHashKeyed = map->keyHashKeyed,
+		.hashKey = map->hashKey,
+		.keyedHash = map->keyedHash,
+		.keyCompare = map->keyCompare,
+		.keyDeinit = (map->keyCopy) ? map->keyDeinit : NULL,
+		.keySize = map->keySize,
+		.elemSize = map->elemSize,
+		.entrySize = sizeof(uint64_t)
+			+ AlignUp(map->keySize)
+			+ AlignUp(map->elemSize),
+		.numPartitions = FoxMax(
+				(numKeys + PARTITION_KEYS - 1) / PARTITION_KEYS,
+				1ul
+		)
+	};
+	size_t numPartitions = frozen->numPartitions;
+
+	/* Collect key-element pairs. */
+	CollectCtx collectCtx = {
+		.map = map,
+		.pairs = malloc(FoxMax(numKeys, 1ul) * sizeof(Pair))
+	};
+	assert(collectCtx.pairs);
+	FoxMapForEachPair(
+			map,
+			(bool (*)(const void *, void *, void *))&CollectPair,
+			&collectCtx
+	);
+
+	/* Group pairs by partition. */
+	Partition * partitions = calloc(numPartitions, sizeof(Partition));
+	Pair * pairs = malloc(FoxMax(numKeys, 1ul) * sizeof(Pair));
+	assert(partitions);
+	assert(pairs);
+	for (size_t idx = 0; idx < numKeys; idx++) {
+		Pair * pair = collectCtx.pairs + idx;
+		partitions[PartitionIdx(pair->hash, numPartitions)].numKeys++;
+	}
+	size_t entryOffset = 0;
+	for (size_t idx = 0; idx < numPartitions; idx++) {
+		Partition * partition = partitions + idx;
+		partition->entryOffset = entryOffset;
+		entryOffset += partition->numKeys;
+		partition->numKeys = 0;
+	}
+	for (size_t idx = 0; idx < numKeys; idx++) {
+		Pair * pair = collectCtx.pairs + idx;
+		Partition * partition = partitions
+			+ PartitionIdx(pair->hash, numPartitions);
+		pairs[partition->entryOffset + partition->numKeys++] = *pair;
+	}
+	free(collectCtx.pairs);
+
+	/* Set aside pairs whose hashes are shared with earlier pairs. */
+	Build build = {
+		.frozen = frozen,
+		.partitions = partitions,
+		.pairs = pairs,
+		.positions = malloc(FoxMax(numKeys, 1ul) * sizeof(size_t)),
+		.keyCopy = map->keyCopy
+	};
+	assert(build.positions);
+	atomic_init(&build.failed, false);
+	BuildParallel(&build, &FlagOverflow);
+	Pair * overflowPairs = malloc(FoxMax(numKeys, 1ul) * sizeof(Pair));
+	assert(overflowPairs);
+	size_t numOverflow = 0;
+	size_t numPilots = 0;
+	entryOffset = 0;
+	for (size_t idx = 0; idx < numPartitions; idx++) {
+		Partition * partition = partitions + idx;
+		size_t pairIdx = partition->entryOffset;
+		size_t pairEnd = pairIdx + partition->numKeys;
+		partition->entryOffset = entryOffset;
+		for (; pairIdx < pairEnd; pairIdx++) {
+			if (pairs[pairIdx].overflow) {
+				overflowPairs[numOverflow++] = pairs[pairIdx];
+			} else {
+				pairs[entryOffset++] = pairs[pairIdx];
+			}
+		}
+		partition->numKeys = entryOffset - partition->entryOffset;
+		partition->pilotOffset = numPilots;
+		partition->numBuckets = partition->numKeys / BUCKET_KEYS + 1;
+		numPilots += partition->numBuckets;
+	}
+	qsort(
+			overflowPairs,
+			numOverflow,
+			sizeof(Pair),
+			(int (*)(const void *, const void *))&PairCompareHash
+	);
+
+	/* Lay out partitions, pilots and entries (overflow last) in one buffer. */
+	size_t partitionsSize = numPartitions * sizeof(Partition);
+	size_t pilotsSize = AlignUp(numPilots * sizeof(uint32_t));
+	frozen->buf = malloc(
+			partitionsSize + pilotsSize + numKeys * frozen->entrySize
+	);
+	assert(frozen->buf);
+	memcpy(frozen->buf, partitions, partitionsSize);
+	free(partitions);
+	frozen->partitions = (Partition *)frozen->buf;
+	frozen->pilots = (uint32_t *)(frozen->buf + partitionsSize);
+	frozen->entries = frozen->buf + partitionsSize + pilotsSize;
+	frozen->overflow = frozen->entries + entryOffset * frozen->entrySize;
+	frozen->numOverflow = numOverflow;
+
+	/* Build partitions. */
+	build.partitions = (Partition *)frozen->partitions;
+	build.pilots = (uint32_t *)frozen->pilots;
+	bool success = BuildParallel(&build, &SearchPilots);
+	if (success) {
+		BuildParallel(&build, &CopyEntries);
+		for (size_t idx = 0; idx < numOverflow; idx++) {
+			WriteEntry(
+					&build,
+					frozen->overflow + idx * frozen->entrySize,
+					overflowPairs + idx
+			);
+		}
+	}
+
+	free(overflowPairs);
+	free(build.positions);
+	free(pairs);
+	if (!success) {
+		free(frozen->buf);
+		*frozen = (FoxFrozenMap){0};
+	}
+
+	return success;
+}
+
+void FoxFrozenMapDeinit(FoxFrozenMap * frozen) {
+	assert(frozen);
+
+	void (* keyDeinit)(void *) = frozen->keyDeinit;
+	if (keyDeinit) {
+		for (size_t idx = 0; idx < frozen->size; idx++) {
+			keyDeinit(EntryKey(frozen->entries + idx * frozen->entrySize));
+		}
+	}
+	free(frozen->buf);
+	*frozen = (FoxFrozenMap){0};
+
+	return;
+}
+
+size_t FoxFrozenMapSize(FoxFrozenMap * frozen) {
+	assert(frozen);
+
+	return frozen->size;
+}
+
+const void * FoxFrozenMapIndex(
+		FoxFrozenMap * frozen,
+		const void * key
+) {
+	assert(frozen);
+	assert(key);
+
+	uint64_t hash = KeyHash(frozen, key);
+	const Partition * partition = frozen->partitions
+		+ PartitionIdx(hash, frozen->numPartitions);
+	size_t numKeys = partition->numKeys;
+	if (numKeys == 0) return NULL;
+
+	uint32_t pilot = frozen->pilots[
+		partition->pilotOffset + BucketIdx(hash, partition->numBuckets)
+	];
+	unsigned char * entry = frozen->entries
+		+ (partition->entryOffset + PilotPosition(hash, pilot, numKeys))
+		* frozen->entrySize;
+	if (*(uint64_t *)entry != hash) return NULL;
+	if (KeyEqual(frozen, key, EntryKey(entry))) return EntryElem(frozen, entry);
+
+	/* Only keys sharing the entry's hash can be in the overflow table. */
+	return (frozen->numOverflow > 0) ? OverflowIndex(frozen, key, hash) : NULL;
+}
+
+void FoxFrozenMapForEachPair(
+		FoxFrozenMap * frozen,
+		bool (* callback)(const void * key, const void * elem, void * ctx),
+		void * ctx
+) {
+	assert(frozen);
+	assert(callback);
+
+	for (size_t idx = 0; idx < frozen->size; idx++) {
+		unsigned char * entry = frozen->entries + idx * frozen->entrySize;
+		if (!callback(EntryKey(entry), EntryElem(frozen, entry), ctx)) break;
+	}
+
+	return;
+}
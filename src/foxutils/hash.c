@@ -5,10 +5,81 @@
  * under Apache 2.0. See file LICENSE for full license details.
  */
 #include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
 
 #include "foxutils/hash.h"
+#include "foxutils/math.h"
 #include "foxutils/splitmix64.h"
-#include "foxutils/xorshift64.h"
+
+
+
+/* ----- PRIVATE MACROS ----- */
+
+#define BYTE_LSBS 0x0101010101010101ull
+
+#define BYTE_MSBS 0x8080808080808080ull
+
+/*
+ * Reading whole aligned words may touch bytes past the end of a string (but
+ * never past the end of its page), which address sanitizers would report.
+ */
+#if defined(__clang__) || defined(__GNUC__)
+#define NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#else
+#define NO_SANITIZE_ADDRESS
+#endif
+
+#if defined(__x86_64__) && (defined(__clang__) || defined(__GNUC__))
+#define HAVE_AVX2 1
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define HAVE_AVX2 0
+#endif
+
+/*
+ * The AES-NI backend's hashes differ from the portable backend's, so
+ * defining FOXHASH_PORTABLE pins the portable backend for reproducibility.
+ */
+#if \
+		!defined(FOXHASH_PORTABLE) \
+		&& defined(__x86_64__) \
+		&& (defined(__clang__) || defined(__GNUC__))
+#define HAVE_AES 1
+#define TARGET_AES __attribute__((target("aes")))
+#else
+#define HAVE_AES 0
+#endif
+
+/* Inputs shorter than one block always use the portable backend. */
+#define AES_BLOCK_SIZE 32
+
+#define SIP_ROUND(v0, v1, v2, v3) \
+	do { \
+		(v0) += (v1); \
+		(v1) = FoxRotL((v1), 13); \
+		(v1) ^= (v0); \
+		(v0) = FoxRotL((v0), 32); \
+		(v2) += (v3); \
+		(v3) = FoxRotL((v3), 16); \
+		(v3) ^= (v2); \
+		(v0) += (v3); \
+		(v3) = FoxRotL((v3), 21); \
+		(v3) ^= (v0); \
+		(v2) += (v1); \
+		(v1) = FoxRotL((v1), 17); \
+		(v1) ^= (v2); \
+		(v2) = FoxRotL((v2), 32); \
+	} while (0)
 
 
 
@@ -27,22 +98,230 @@ typedef union HashVal {
 
 
 
+/* ----- PRIVATE GLOBALS ----- */
+
+static FoxHashKey processKey;
+
+static pthread_once_t processKeyOnce = PTHREAD_ONCE_INIT;
+
+static atomic_uint_fast64_t processKeyCounter = 0;
+
+
+
 /* ----- PRIVATE FUNCTIONS ----- */
 
-static inline uint64_t HashMem(
+static inline uint64_t MixBlock(uint64_t state) {
+	state ^= state << 12;
+	state ^= state >> 25;
+	state ^= state << 27;
+
+	return state;
+}
+
+static inline uint64_t Finalize(uint64_t state) {
+	state += 0x9e3779b97f4a7c15ull;
+	state = (state ^ (state >> 30)) * 0xbf58476d1ce4e5b9ull;
+	state = (state ^ (state >> 27)) * 0x94d049bb133111ebull;
+
+	return state ^ (state >> 31);
+}
+
+/*
+ * Equivalent to HashMem() over a single 64-bit key.
+ */
+static inline uint64_t HashU64(const void * key) {
+	uint64_t val;
+	memcpy(&val, key, sizeof(uint64_t));
+
+	return FoxHashU64(val);
+}
+
+/*
+ * Equivalent to HashMem() over a single 32-bit key.
+ */
+static inline uint64_t HashU32(const void * key) {
+	uint32_t val;
+	memcpy(&val, key, sizeof(uint32_t));
+
+	return FoxHashU32(val);
+}
+
+static void HashU64ManyScalar(
+		const void * in,
+		size_t num,
+		uint64_t * out
+) {
+	const unsigned char * keys = in;
+	for (size_t idx = 0; idx < num; idx++) {
+		out[idx] = HashU64(keys + idx * sizeof(uint64_t));
+	}
+
+	return;
+}
+
+static void HashU32ManyScalar(
+		const void * in,
+		size_t num,
+		uint64_t * out
+) {
+	const unsigned char * keys = in;
+	for (size_t idx = 0; idx < num; idx++) {
+		out[idx] = HashU32(keys + idx * sizeof(uint32_t));
+	}
+
+	return;
+}
+
+#if HAVE_AVX2
+/*
+ * Multiply 64-bit lanes by a constant (AVX2 only multiplies 32-bit halves).
+ */
+TARGET_AVX2 static inline __m256i Mul64(
+		__m256i val,
+		__m256i factor
+) {
+	__m256i lo = _mm256_mul_epu32(val, factor);
+	__m256i cross = _mm256_add_epi64(
+			_mm256_mul_epu32(_mm256_srli_epi64(val, 32), factor),
+			_mm256_mul_epu32(val, _mm256_srli_epi64(factor, 32))
+	);
+
+	return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+/*
+ * Equivalent to Finalize(MixBlock()) on four lanes at once.
+ */
+TARGET_AVX2 static inline __m256i HashBlocks(__m256i state) {
+	state = _mm256_xor_si256(state, _mm256_slli_epi64(state, 12));
+	state = _mm256_xor_si256(state, _mm256_srli_epi64(state, 25));
+	state = _mm256_xor_si256(state, _mm256_slli_epi64(state, 27));
+
+	state = _mm256_add_epi64(
+			state,
+			_mm256_set1_epi64x(0x9e3779b97f4a7c15ull)
+	);
+	state = Mul64(
+			_mm256_xor_si256(state, _mm256_srli_epi64(state, 30)),
+			_mm256_set1_epi64x(0xbf58476d1ce4e5b9ull)
+	);
+	state = Mul64(
+			_mm256_xor_si256(state, _mm256_srli_epi64(state, 27)),
+			_mm256_set1_epi64x(0x94d049bb133111ebull)
+	);
+
+	return _mm256_xor_si256(state, _mm256_srli_epi64(state, 31));
+}
+
+TARGET_AVX2 static void HashU64ManyAVX2(
+		const void * in,
+		size_t num,
+		uint64_t * out
+) {
+	const unsigned char * keys = in;
+	size_t idx = 0;
+
+	/* Hash two vectors per iteration to overlap their multiplications. */
+	for (; idx + 8 <= num; idx += 8) {
+		const unsigned char * batch = keys + idx * sizeof(uint64_t);
+		__m256i blocksA = _mm256_loadu_si256((const __m256i *)batch);
+		__m256i blocksB = _mm256_loadu_si256((const __m256i *)batch + 1);
+		_mm256_storeu_si256((__m256i *)(out + idx), HashBlocks(blocksA));
+		_mm256_storeu_si256((__m256i *)(out + idx + 4), HashBlocks(blocksB));
+	}
+	HashU64ManyScalar(keys + idx * sizeof(uint64_t), num - idx, out + idx);
+
+	return;
+}
+
+TARGET_AVX2 static void HashU32ManyAVX2(
+		const void * in,
+		size_t num,
+		uint64_t * out
+) {
+	const unsigned char * keys = in;
+	size_t idx = 0;
+
+	/* Hash two vectors per iteration to overlap their multiplications. */
+	for (; idx + 8 <= num; idx += 8) {
+		const unsigned char * batch = keys + idx * sizeof(uint32_t);
+		__m128i keysA = _mm_loadu_si128((const __m128i *)batch);
+		__m128i keysB = _mm_loadu_si128((const __m128i *)batch + 1);
+		__m256i blocksA = _mm256_cvtepu32_epi64(keysA);
+		__m256i blocksB = _mm256_cvtepu32_epi64(keysB);
+		_mm256_storeu_si256((__m256i *)(out + idx), HashBlocks(blocksA));
+		_mm256_storeu_si256((__m256i *)(out + idx + 4), HashBlocks(blocksB));
+	}
+	HashU32ManyScalar(keys + idx * sizeof(uint32_t), num - idx, out + idx);
+
+	return;
+}
+#endif
+
+static inline bool HaveAVX2(void) {
+#if HAVE_AVX2
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+/*
+ * Convert between memory order and an order in which the first byte in
+ * memory occupies the least significant bits.
+ */
+static inline uint64_t LittleEndian(uint64_t word) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	word = __builtin_bswap64(word);
+#endif
+
+	return word;
+}
+
+/*
+ * Load an aligned word such that the first byte occupies the least
+ * significant bits of the result.
+ */
+NO_SANITIZE_ADDRESS static inline uint64_t LoadWord(
+		const unsigned char * word
+) {
+	uint64_t val;
+	memcpy(&val, __builtin_assume_aligned(word, 8), sizeof(uint64_t));
+
+	return LittleEndian(val);
+}
+
+/*
+ * Flag the zero bytes of a word. Only the lowest flag is guaranteed to be
+ * exact, but that is all which is needed to find a terminator.
+ */
+static inline uint64_t MatchZero(uint64_t word) {
+	return (word - BYTE_LSBS) & ~word & BYTE_MSBS;
+}
+
+static inline size_t MatchIdx(uint64_t match) {
+	return (size_t)__builtin_ctzll(match) >> 3;
+}
+
+static inline uint64_t LowBytes(size_t num) {
+	return (num == 0) ? 0 : ~0ull >> (64 - num * 8);
+}
+
+static inline uint64_t HashMemPortable(
 		const void * mem,
-		size_t num
+		size_t num,
+		uint64_t seed
 ) {
 	MemView view;
 	view.raw = mem;
 	HashVal hash;
-	hash.packed = 0;
+	hash.packed = seed;
 
 	/* Mix as many 64-bit blocks as possible. */
 	size_t numBlocks = num / 8;
 	for (unsigned int idx = 0; idx < numBlocks; idx++) {
 		hash.packed ^= view.blocks[idx];
-		FoxXorshift64Primitive(&hash.packed);
+		hash.packed = MixBlock(hash.packed);
 	}
 
 	/* Mix unaligned trailing bytes. */
@@ -50,11 +329,600 @@ static inline uint64_t HashMem(
 		for (unsigned int idx = num & ~(size_t)0x7; idx < num; idx++) {
 			hash.bytes[idx & 0x7] ^= view.bytes[idx];
 		}
-		FoxXorshift64Primitive(&hash.packed);
+		hash.packed = MixBlock(hash.packed);
 	}
 
 	/* Finalize hash. */
-	return FoxSplitMix64Primitive(&hash.packed);
+	return Finalize(hash.packed);
+}
+
+#if HAVE_AES
+TARGET_AES static inline void AESInit(
+		__m128i lanes[2],
+		uint64_t seed
+) {
+	lanes[0] = _mm_set_epi64x(
+			(long long)0x13198a2e03707344ull,
+			(long long)(seed ^ 0x243f6a8885a308d3ull)
+	);
+	lanes[1] = _mm_set_epi64x(
+			(long long)0x082efa98ec4e6c89ull,
+			(long long)(seed ^ 0xa4093822299f31d0ull)
+	);
+
+	return;
+}
+
+/*
+ * Mix a block into two independent lanes, so that consecutive rounds
+ * overlap.
+ */
+TARGET_AES static inline void AESMix(
+		__m128i lanes[2],
+		const unsigned char * block
+) {
+	const __m128i * halves = (const __m128i *)block;
+	lanes[0] = _mm_aesenc_si128(lanes[0], _mm_loadu_si128(halves));
+	lanes[1] = _mm_aesenc_si128(lanes[1], _mm_loadu_si128(halves + 1));
+
+	return;
+}
+
+/*
+ * Mix an incomplete block, padded with zeros.
+ */
+TARGET_AES static inline void AESMixPartial(
+		__m128i lanes[2],
+		const unsigned char * bytes,
+		size_t num
+) {
+	unsigned char block[AES_BLOCK_SIZE] = {0};
+	memcpy(block, bytes, num);
+	AESMix(lanes, block);
+
+	return;
+}
+
+/*
+ * Combine both lanes into a well-mixed 128-bit state.
+ */
+TARGET_AES static inline __m128i AESFinalizeState(
+		const __m128i lanes[2],
+		size_t num
+) {
+	__m128i state = _mm_xor_si128(lanes[0], _mm_set_epi64x(0, (long long)num));
+	state = _mm_aesenc_si128(state, lanes[1]);
+	state = _mm_aesenc_si128(
+			state,
+			_mm_set_epi64x(
+					(long long)0xbe5466cf34e90c6cull,
+					(long long)0x452821e638d01377ull
+			)
+	);
+	state = _mm_aesenc_si128(
+			state,
+			_mm_set_epi64x(
+					(long long)0x3f84d5b5b5470917ull,
+					(long long)0xc0ac29b7c97c50ddull
+			)
+	);
+
+	return state;
+}
+
+TARGET_AES static inline uint64_t AESFinalize(
+		const __m128i lanes[2],
+		size_t num
+) {
+	__m128i state = AESFinalizeState(lanes, num);
+	uint64_t hash = (
+			(uint64_t)_mm_cvtsi128_si64(state)
+			^ (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(state, state))
+	);
+
+	return Finalize(hash);
+}
+
+TARGET_AES static inline void AESMixMem(
+		__m128i lanes[2],
+		const void * mem,
+		size_t num
+) {
+	const unsigned char * bytes = mem;
+
+	/* Mix as many complete blocks as possible. */
+	size_t numBlocks = num / AES_BLOCK_SIZE;
+	for (size_t idx = 0; idx < numBlocks; idx++) {
+		AESMix(lanes, bytes + idx * AES_BLOCK_SIZE);
+	}
+
+	/* Mix trailing bytes. */
+	if (num % AES_BLOCK_SIZE != 0) {
+		AESMixPartial(
+				lanes,
+				bytes + numBlocks * AES_BLOCK_SIZE,
+				num % AES_BLOCK_SIZE
+		);
+	}
+
+	return;
+}
+
+TARGET_AES static uint64_t HashMemAES(
+		const void * mem,
+		size_t num,
+		uint64_t seed
+) {
+	__m128i lanes[2];
+	AESInit(lanes, seed);
+	AESMixMem(lanes, mem, num);
+
+	/* Finalize hash. */
+	return AESFinalize(lanes, num);
+}
+
+TARGET_AES static FoxHash128 HashMem128AES(
+		const void * mem,
+		size_t num
+) {
+	__m128i lanes[2];
+	AESInit(lanes, 0);
+	AESMixMem(lanes, mem, num);
+
+	/* Finalize both halves. */
+	__m128i state = AESFinalizeState(lanes, num);
+
+	return (FoxHash128){
+		.lo = Finalize((uint64_t)_mm_cvtsi128_si64(state)),
+		.hi = Finalize(
+				(uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(state, state))
+		)
+	};
+}
+
+TARGET_AES static void HasherInitAES(FoxHasher * hasher) {
+	*hasher = (FoxHasher){
+		.state = 0,
+		.block = 0,
+		.num = 0
+	};
+	__m128i lanes[2];
+	AESInit(lanes, 0);
+	_mm_storeu_si128((__m128i *)hasher->lanes, lanes[0]);
+	_mm_storeu_si128((__m128i *)hasher->lanes + 1, lanes[1]);
+
+	return;
+}
+
+TARGET_AES static void HasherUpdateAES(
+		FoxHasher * hasher,
+		const unsigned char * bytes,
+		size_t num
+) {
+	__m128i lanes[2] = {
+		_mm_loadu_si128((const __m128i *)hasher->lanes),
+		_mm_loadu_si128((const __m128i *)hasher->lanes + 1)
+	};
+
+	/* Complete pending block. */
+	size_t pending = hasher->num % AES_BLOCK_SIZE;
+	hasher->num += num;
+	if (pending != 0) {
+		size_t numTaken = AES_BLOCK_SIZE - pending;
+		if (num < numTaken) {
+			memcpy(hasher->buffer + pending, bytes, num);
+			return;
+		}
+		memcpy(hasher->buffer + pending, bytes, numTaken);
+		AESMix(lanes, hasher->buffer);
+		bytes += numTaken;
+		num -= numTaken;
+	}
+
+	/* Mix as many complete blocks as possible. */
+	for (; num >= AES_BLOCK_SIZE; num -= AES_BLOCK_SIZE) {
+		AESMix(lanes, bytes);
+		bytes += AES_BLOCK_SIZE;
+	}
+
+	/* Keep trailing bytes for later. */
+	memcpy(hasher->buffer, bytes, num);
+	_mm_storeu_si128((__m128i *)hasher->lanes, lanes[0]);
+	_mm_storeu_si128((__m128i *)hasher->lanes + 1, lanes[1]);
+
+	return;
+}
+
+TARGET_AES static uint64_t HasherFinalAES(FoxHasher * hasher) {
+	/* Short inputs were only buffered. */
+	if (hasher->num < AES_BLOCK_SIZE) {
+		return HashMemPortable(hasher->buffer, hasher->num, 0);
+	}
+
+	__m128i lanes[2] = {
+		_mm_loadu_si128((const __m128i *)hasher->lanes),
+		_mm_loadu_si128((const __m128i *)hasher->lanes + 1)
+	};
+	if (hasher->num % AES_BLOCK_SIZE != 0) {
+		AESMixPartial(lanes, hasher->buffer, hasher->num % AES_BLOCK_SIZE);
+	}
+
+	return AESFinalize(lanes, hasher->num);
+}
+#endif
+
+/*
+ * Absorb a block into two 64-bit lanes, each through its own invertible
+ * update, so that the lanes only collide independently.
+ */
+static inline void MixBlock128(
+		uint64_t * lo,
+		uint64_t * hi,
+		uint64_t block
+) {
+	*lo = (*lo ^ block) * 0x9e3779b97f4a7c15ull;
+	*lo ^= *lo >> 32;
+	*hi = FoxRotL((*hi + block) * 0xc2b2ae3d27d4eb4full, 31);
+
+	return;
+}
+
+static inline FoxHash128 HashMem128Portable(
+		const void * mem,
+		size_t num
+) {
+	const unsigned char * bytes = mem;
+	uint64_t lo = 0x243f6a8885a308d3ull;
+	uint64_t hi = 0x13198a2e03707344ull;
+
+	/* Mix as many 64-bit blocks as possible. */
+	size_t numBlocks = num / 8;
+	for (size_t idx = 0; idx < numBlocks; idx++) {
+		uint64_t block;
+		memcpy(&block, bytes + idx * 8, sizeof(uint64_t));
+		MixBlock128(&lo, &hi, LittleEndian(block));
+	}
+
+	/* Mix trailing bytes. */
+	if ((num & 0x7) != 0) {
+		uint64_t block = 0;
+		memcpy(&block, bytes + numBlocks * 8, num & 0x7);
+		MixBlock128(&lo, &hi, LittleEndian(block));
+	}
+
+	/*
+	 * Finalize both halves. Each depends on both lanes, yet the pair remains a
+	 * bijection of them.
+	 */
+	lo = Finalize(lo ^ num);
+	hi = Finalize(hi);
+	lo += hi;
+
+	return (FoxHash128){.lo = lo, .hi = hi ^ Finalize(lo)};
+}
+
+static void HasherInitPortable(FoxHasher * hasher) {
+	*hasher = (FoxHasher){
+		.state = 0,
+		.block = 0,
+		.num = 0
+	};
+
+	return;
+}
+
+static void HasherUpdatePortable(
+		FoxHasher * hasher,
+		const unsigned char * bytes,
+		size_t num
+) {
+	uint64_t state = hasher->state;
+
+	/* Complete pending block. */
+	size_t pending = hasher->num & 0x7;
+	hasher->num += num;
+	if (pending != 0) {
+		size_t numTaken = 8 - pending;
+		if (num < numTaken) {
+			memcpy((unsigned char *)&hasher->block + pending, bytes, num);
+			return;
+		}
+		memcpy((unsigned char *)&hasher->block + pending, bytes, numTaken);
+		state ^= hasher->block;
+		state = MixBlock(state);
+		hasher->block = 0;
+		bytes += numTaken;
+		num -= numTaken;
+	}
+
+	/* Mix as many 64-bit blocks as possible. */
+	for (; num >= 8; num -= 8, bytes += 8) {
+		uint64_t block;
+		memcpy(&block, bytes, sizeof(uint64_t));
+		state ^= block;
+		state = MixBlock(state);
+	}
+
+	/* Keep trailing bytes for later. */
+	memcpy(&hasher->block, bytes, num);
+	hasher->state = state;
+
+	return;
+}
+
+static uint64_t HasherFinalPortable(FoxHasher * hasher) {
+	uint64_t state = hasher->state;
+
+	/* Mix incomplete block. */
+	if ((hasher->num & 0x7) != 0) {
+		state ^= hasher->block;
+		state = MixBlock(state);
+	}
+
+	/* Finalize hash. */
+	return Finalize(state);
+}
+
+#if HAVE_AES
+/*
+ * The backend is selected once, by a constructor before main() runs, so that
+ * hashing only calls through these pointers. Each starts out at a resolver in
+ * case another constructor hashes first.
+ */
+static uint64_t HashMemResolve(const void *, size_t, uint64_t);
+static FoxHash128 HashMem128Resolve(const void *, size_t);
+static void HasherInitResolve(FoxHasher *);
+static void HasherUpdateResolve(FoxHasher *, const unsigned char *, size_t);
+static uint64_t HasherFinalResolve(FoxHasher *);
+
+static pthread_once_t backendOnce = PTHREAD_ONCE_INIT;
+
+/* Only called for inputs of at least AES_BLOCK_SIZE bytes. */
+static uint64_t (* hashMemLong)(const void *, size_t, uint64_t) = (
+		&HashMemResolve
+);
+
+static FoxHash128 (* hashMem128Long)(const void *, size_t) = (
+		&HashMem128Resolve
+);
+
+static void (* hasherInit)(FoxHasher *) = &HasherInitResolve;
+
+static void (* hasherUpdate)(FoxHasher *, const unsigned char *, size_t) = (
+		&HasherUpdateResolve
+);
+
+static uint64_t (* hasherFinal)(FoxHasher *) = &HasherFinalResolve;
+
+static void SelectBackend(void) {
+	unsigned int eax, ebx, ecx, edx;
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES)) {
+		hashMemLong = &HashMemAES;
+		hashMem128Long = &HashMem128AES;
+		hasherInit = &HasherInitAES;
+		hasherUpdate = &HasherUpdateAES;
+		hasherFinal = &HasherFinalAES;
+	} else {
+		hashMemLong = &HashMemPortable;
+		hashMem128Long = &HashMem128Portable;
+		hasherInit = &HasherInitPortable;
+		hasherUpdate = &HasherUpdatePortable;
+		hasherFinal = &HasherFinalPortable;
+	}
+
+	return;
+}
+
+__attribute__((constructor)) static void InitBackend(void) {
+	pthread_once(&backendOnce, &SelectBackend);
+
+	return;
+}
+
+static uint64_t HashMemResolve(
+		const void * mem,
+		size_t num,
+		uint64_t seed
+) {
+	pthread_once(&backendOnce, &SelectBackend);
+
+	return hashMemLong(mem, num, seed);
+}
+
+static FoxHash128 HashMem128Resolve(
+		const void * mem,
+		size_t num
+) {
+	pthread_once(&backendOnce, &SelectBackend);
+
+	return hashMem128Long(mem, num);
+}
+
+static void HasherInitResolve(FoxHasher * hasher) {
+	pthread_once(&backendOnce, &SelectBackend);
+	hasherInit(hasher);
+
+	return;
+}
+
+static void HasherUpdateResolve(
+		FoxHasher * hasher,
+		const unsigned char * bytes,
+		size_t num
+) {
+	pthread_once(&backendOnce, &SelectBackend);
+	hasherUpdate(hasher, bytes, num);
+
+	return;
+}
+
+static uint64_t HasherFinalResolve(FoxHasher * hasher) {
+	pthread_once(&backendOnce, &SelectBackend);
+
+	return hasherFinal(hasher);
+}
+#else
+#define hasherInit HasherInitPortable
+#define hasherUpdate HasherUpdatePortable
+#define hasherFinal HasherFinalPortable
+#endif
+
+/*
+ * Hash memory with the AES-NI backend if the CPU supports it, or the portable
+ * backend otherwise.
+ */
+static inline uint64_t HashMem(
+		const void * mem,
+		size_t num,
+		uint64_t seed
+) {
+#if HAVE_AES
+	if (num >= AES_BLOCK_SIZE) return hashMemLong(mem, num, seed);
+#endif
+
+	return HashMemPortable(mem, num, seed);
+}
+
+static inline FoxHash128 HashMem128(
+		const void * mem,
+		size_t num
+) {
+#if HAVE_AES
+	if (num >= AES_BLOCK_SIZE) return hashMem128Long(mem, num);
+#endif
+
+	return HashMem128Portable(mem, num);
+}
+
+/*
+ * Equivalent to HashMem() over the string's characters, but reads aligned
+ * 64-bit words (which never cross a page boundary) and finds the terminator
+ * a word at a time.
+ */
+static uint64_t HashString(
+		const char * str,
+		uint64_t seed
+) {
+	uint64_t hash = seed;
+#if HAVE_AES
+	size_t numHashed = 0;
+#endif
+
+	/* Blocks start at the string, which need not be aligned. */
+	uintptr_t addr = (uintptr_t)str;
+	size_t offset = addr & 0x7;
+	size_t shift = offset * 8;
+	const unsigned char * word = (
+			(const unsigned char *)(addr & ~(uintptr_t)0x7)
+	);
+	uint64_t prefixMask = LowBytes(offset);
+
+	/* Bytes preceding the string are never mistaken for its terminator. */
+	uint64_t lo = LoadWord(word) | prefixMask;
+	while (true) {
+		uint64_t match = MatchZero(lo);
+		if (match) {
+			size_t num = MatchIdx(match) - offset;
+			if (num > 0) {
+				hash ^= LittleEndian((lo >> shift) & LowBytes(num));
+				hash = MixBlock(hash);
+			}
+			break;
+		}
+
+		/* The terminator lies beyond this word, so the next one is safe. */
+		word += sizeof(uint64_t);
+		uint64_t hi = LoadWord(word);
+		uint64_t block = (
+				(offset == 0) ?
+				lo
+				: (lo >> shift) | (hi << (64 - shift))
+		);
+		match = MatchZero(hi | ~prefixMask);
+		if (match && offset > 0) {
+			size_t num = 8 - offset + MatchIdx(match);
+			hash ^= LittleEndian(block & LowBytes(num));
+			hash = MixBlock(hash);
+			break;
+		}
+
+		hash ^= LittleEndian(block);
+		hash = MixBlock(hash);
+		lo = hi | prefixMask;
+
+		/* Longer strings belong to the AES-NI backend. */
+#if HAVE_AES
+		numHashed += sizeof(uint64_t);
+		if (
+				numHashed == AES_BLOCK_SIZE
+				&& hashMemLong != &HashMemPortable
+		) {
+			return HashMem(str, numHashed + strlen(str + numHashed), seed);
+		}
+#endif
+	}
+
+	/* Finalize hash. */
+	return Finalize(hash);
+}
+
+/*
+ * SipHash-1-3 (one compression round per block and three finalization
+ * rounds), the reduced-round SipHash variant used by several languages' hash
+ * tables.
+ */
+static inline uint64_t SipHash13(
+		const void * mem,
+		size_t num,
+		const FoxHashKey * key
+) {
+	const unsigned char * bytes = mem;
+	uint64_t v0 = key->k0 ^ 0x736f6d6570736575ull;
+	uint64_t v1 = key->k1 ^ 0x646f72616e646f6dull;
+	uint64_t v2 = key->k0 ^ 0x6c7967656e657261ull;
+	uint64_t v3 = key->k1 ^ 0x7465646279746573ull;
+
+	/* Compress as many 64-bit blocks as possible. */
+	size_t numBlocks = num / 8;
+	for (size_t idx = 0; idx < numBlocks; idx++) {
+		uint64_t block;
+		memcpy(&block, bytes + idx * 8, sizeof(uint64_t));
+		block = LittleEndian(block);
+		v3 ^= block;
+		SIP_ROUND(v0, v1, v2, v3);
+		v0 ^= block;
+	}
+
+	/* Compress trailing bytes along with the length. */
+	uint64_t block = 0;
+	memcpy(&block, bytes + numBlocks * 8, num & 0x7);
+	block = LittleEndian(block) | ((uint64_t)num << 56);
+	v3 ^= block;
+	SIP_ROUND(v0, v1, v2, v3);
+	v0 ^= block;
+
+	/* Finalize hash. */
+	v2 ^= 0xff;
+	SIP_ROUND(v0, v1, v2, v3);
+	SIP_ROUND(v0, v1, v2, v3);
+	SIP_ROUND(v0, v1, v2, v3);
+
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+static void InitProcessKey(void) {
+	if (getentropy(&processKey, sizeof(FoxHashKey)) != 0) {
+		/* Fall back on weaker sources of entropy. */
+		uint64_t state = (
+				(uint64_t)time(NULL)
+				^ ((uint64_t)getpid() << 32)
+				^ (uint64_t)(uintptr_t)&processKey
+		);
+		processKey.k0 = FoxSplitMix64Primitive(&state);
+		processKey.k1 = FoxSplitMix64Primitive(&state);
+	}
+
+	return;
 }
 
 
@@ -67,67 +935,212 @@ uint64_t FoxHashMem(
 ) {
 	assert(mem);
 
-	return HashMem(mem, num);
+	return HashMem(mem, num, 0);
+}
+
+uint64_t FoxHashMemSeeded(
+		const void * mem,
+		size_t num,
+		uint64_t seed
+) {
+	assert(mem);
+
+	return HashMem(mem, num, seed);
+}
+
+uint64_t FoxHashMemKeyed(
+		const void * mem,
+		size_t num,
+		const FoxHashKey * key
+) {
+	assert(mem);
+	assert(key);
+
+	return SipHash13(mem, num, key);
+}
+
+FoxHash128 FoxHashMem128(
+		const void * mem,
+		size_t num
+) {
+	assert(mem);
+
+	return HashMem128(mem, num);
 }
 
 uint64_t FoxHashString(const char * str) {
 	assert(str);
-	HashVal hash;
-	hash.packed = 0;
 
-	/* Mix bytes. */
-	unsigned int charIdx = 0;
-	char curChar;
-	while ((curChar = str[charIdx]) != '\0') {
-		hash.bytes[charIdx & 0x7] ^= (uint8_t)curChar;
-		if ((++charIdx & 0x7) == 0) FoxXorshift64Primitive(&hash.packed);
+	return HashString(str, 0);
+}
+
+uint64_t FoxHashStringSeeded(
+		const char * str,
+		uint64_t seed
+) {
+	assert(str);
+
+	return HashString(str, seed);
+}
+
+uint64_t FoxHashStringKeyed(
+		const char * str,
+		const FoxHashKey * key
+) {
+	assert(str);
+	assert(key);
+
+	return SipHash13(str, strlen(str), key);
+}
+
+FoxHash128 FoxHashString128(const char * str) {
+	assert(str);
+
+	return HashMem128(str, strlen(str));
+}
+
+void FoxHashKeyRandom(FoxHashKey * key) {
+	assert(key);
+
+	/* Derive a distinct key from the process key without a system call. */
+	pthread_once(&processKeyOnce, &InitProcessKey);
+	uint64_t state = processKey.k0 ^ atomic_fetch_add(&processKeyCounter, 1);
+	key->k0 = FoxSplitMix64Primitive(&state);
+	state ^= processKey.k1;
+	key->k1 = FoxSplitMix64Primitive(&state);
+
+	return;
+}
+
+void FoxHashU64Many(
+		const uint64_t * in,
+		size_t num,
+		uint64_t * out
+) {
+	assert(in || num == 0);
+	assert(out || num == 0);
+
+#if HAVE_AVX2
+	if (HaveAVX2()) {
+		HashU64ManyAVX2(in, num, out);
+		return;
 	}
-	if ((charIdx & 0x7) != 0) FoxXorshift64Primitive(&hash.packed);
+#endif
+	HashU64ManyScalar(in, num, out);
 
-	/* Finalize hash. */
-	return FoxSplitMix64Primitive(&hash.packed);
+	return;
+}
+
+void FoxHashU32Many(
+		const uint32_t * in,
+		size_t num,
+		uint64_t * out
+) {
+	assert(in || num == 0);
+	assert(out || num == 0);
+
+#if HAVE_AVX2
+	if (HaveAVX2()) {
+		HashU32ManyAVX2(in, num, out);
+		return;
+	}
+#endif
+	HashU32ManyScalar(in, num, out);
+
+	return;
+}
+
+void FoxHashMemMany(
+		const void * in,
+		size_t stride,
+		size_t num,
+		uint64_t * out
+) {
+	assert(in || num == 0);
+	assert(out || num == 0);
+
+	if (stride == sizeof(uint64_t)) {
+		FoxHashU64Many(in, num, out);
+	} else if (stride == sizeof(uint32_t)) {
+		FoxHashU32Many(in, num, out);
+	} else {
+		const unsigned char * keys = in;
+		for (size_t idx = 0; idx < num; idx++) {
+			out[idx] = HashMem(keys + idx * stride, stride, 0);
+		}
+	}
+
+	return;
+}
+
+void FoxHasherInit(FoxHasher * hasher) {
+	assert(hasher);
+
+	hasherInit(hasher);
+
+	return;
+}
+
+void FoxHasherUpdate(
+		FoxHasher * hasher,
+		const void * mem,
+		size_t num
+) {
+	assert(hasher);
+	assert(mem || num == 0);
+	if (num == 0) return;
+
+	hasherUpdate(hasher, mem, num);
+
+	return;
+}
+
+uint64_t FoxHasherFinal(FoxHasher * hasher) {
+	assert(hasher);
+
+	return hasherFinal(hasher);
 }
 
 uint64_t FoxHashChar(char val) {
-	return HashMem(&val, sizeof(char));
+	return FoxHashKeySeeded(&val, sizeof(char), 0);
 }
 
 uint64_t FoxHashSChar(signed char val) {
-	return HashMem(&val, sizeof(signed char));
+	return FoxHashKeySeeded(&val, sizeof(signed char), 0);
 }
 
 uint64_t FoxHashUChar(unsigned char val) {
-	return HashMem(&val, sizeof(unsigned char));
+	return FoxHashKeySeeded(&val, sizeof(unsigned char), 0);
 }
 
 uint64_t FoxHashShort(short val) {
-	return HashMem(&val, sizeof(short));
+	return FoxHashKeySeeded(&val, sizeof(short), 0);
 }
 
 uint64_t FoxHashUShort(unsigned short val) {
-	return HashMem(&val, sizeof(unsigned short));
+	return FoxHashKeySeeded(&val, sizeof(unsigned short), 0);
 }
 
 uint64_t FoxHashInt(int val) {
-	return HashMem(&val, sizeof(int));
+	return FoxHashKeySeeded(&val, sizeof(int), 0);
 }
 
 uint64_t FoxHashUInt(unsigned int val) {
-	return HashMem(&val, sizeof(unsigned int));
+	return FoxHashKeySeeded(&val, sizeof(unsigned int), 0);
 }
 
 uint64_t FoxHashLong(long val) {
-	return HashMem(&val, sizeof(long));
+	return FoxHashKeySeeded(&val, sizeof(long), 0);
 }
 
 uint64_t FoxHashULong(unsigned long val) {
-	return HashMem(&val, sizeof(unsigned long));
+	return FoxHashKeySeeded(&val, sizeof(unsigned long), 0);
 }
 
 uint64_t FoxHashLongLong(long long val) {
-	return HashMem(&val, sizeof(long long));
+	return FoxHashKeySeeded(&val, sizeof(long long), 0);
 }
 
 uint64_t FoxHashULongLong(unsigned long long val) {
-	return HashMem(&val, sizeof(unsigned long long));
+	return FoxHashKeySeeded(&val, sizeof(unsigned long long), 0);
 }
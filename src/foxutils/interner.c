@@ -0,0 +1,141 @@
+/*
+ * Copyright 2020 Garrett Russell Fairburn
+ * 
+ * This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "foxutils/interner.h"
+#include "foxutils/stringmap.h"
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+FoxInterner * FoxInternerNew(void) {
+	FoxInterner * interner = malloc(sizeof(FoxInterner));
+	assert(interner);
+	FoxInternerInit(interner);
+
+	return interner;
+}
+
+void FoxInternerFree(FoxInterner * interner) {
+	FoxInternerDeinit(interner);
+	free(interner);
+
+	return;
+}
+
+void FoxInternerInit(FoxInterner * interner) {
+	assert(interner);
+
+	/* The map borrows its keys from the arena, so it never copies them. */
+	FoxStringMapInitBorrowed(
+			&interner->ids,
+			sizeof(uint32_t),
+			FOXMAP_DEF_INITSLOTS,
+			FOXMAP_DEF_GROWRATE,
+			FOXMAP_DEF_LFTHRESH
+	);
+	FoxArrayInit(
+			&interner->strings,
+			sizeof(const char *),
+			FOXARRAY_DEF_INITCAP,
+			FOXARRAY_DEF_GROWRATE
+	);
+	FoxArenaInit(&interner->arena, FOXARENA_DEF_CHUNKSIZE);
+
+	return;
+}
+
+void FoxInternerDeinit(FoxInterner * interner) {
+	assert(interner);
+
+	FoxMapDeinit(&interner->ids);
+	FoxArrayDeinit(&interner->strings);
+	FoxArenaDeinit(&interner->arena);
+
+	return;
+}
+
+size_t FoxInternerSize(FoxInterner * interner) {
+	assert(interner);
+
+	return FoxArraySize(&interner->strings);
+}
+
+uint32_t FoxInternerIntern(
+		FoxInterner * interner,
+		const char * str
+) {
+	assert(str);
+
+	return FoxInternerInternN(interner, str, strlen(str));
+}
+
+uint32_t FoxInternerInternN(
+		FoxInterner * interner,
+		const char * str,
+		size_t len
+) {
+	assert(interner);
+	assert(str);
+
+	uint64_t hash = FoxStringMapHash(&interner->ids, str, len);
+	uint32_t * id = FoxStringMapIndexHashed(&interner->ids, str, len, hash);
+	if (id) return *id;
+
+	/* Store canonical copy. */
+	size_t newId = FoxArraySize(&interner->strings);
+	assert(newId < FOXINTERNER_NULL_ID);
+	const char * canonical = FoxStringMapKeyAlloc(&interner->arena, str, len);
+
+	*(const char **)FoxArrayPush(&interner->strings) = canonical;
+	id = FoxMapInsertHashed(&interner->ids, &canonical, hash);
+	*id = newId;
+
+	return *id;
+}
+
+uint32_t FoxInternerFind(
+		FoxInterner * interner,
+		const char * str
+) {
+	assert(str);
+
+	return FoxInternerFindN(interner, str, strlen(str));
+}
+
+uint32_t FoxInternerFindN(
+		FoxInterner * interner,
+		const char * str,
+		size_t len
+) {
+	assert(interner);
+	assert(str);
+
+	uint32_t * id = FoxStringMapIndexN(&interner->ids, str, len);
+
+	return (id) ? *id : FOXINTERNER_NULL_ID;
+}
+
+const char * FoxInternerString(
+		FoxInterner * interner,
+		uint32_t id
+) {
+	assert(interner);
+	assert(id < FoxArraySize(&interner->strings));
+
+	return *(const char **)FoxArrayIndex(&interner->strings, id);
+}
+
+size_t FoxInternerLength(
+		FoxInterner * interner,
+		uint32_t id
+) {
+	return FoxStringMapKeyLength(FoxInternerString(interner, id));
+}
@@ -5,6 +5,7 @@
  * under Apache 2.0. See file LICENSE for full license details.
  */
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -16,74 +17,665 @@
 
 /* ----- PRIVATE MACROS ----- */
 
-#define ItemSize(map) (sizeof(Item) + (map)->elemSize)
+#define BATCH_SIZE 32ul
 
-#define SlotEntrySize(map) (sizeof(SlotEntry) + (map)->keySize)
+#define ITEM_ALIGN 8ul
+
+/* The first item chunk holds 1 << ITEM_CHUNK_SHIFT items. */
+#define ITEM_CHUNK_SHIFT 4
+
+#define ChunkStart(chunkIdx) (((1ul << (chunkIdx)) - 1) << ITEM_CHUNK_SHIFT)
+
+#define NULL_ITEM SIZE_MAX
+
+#define AlignUp(size) (((size) + ITEM_ALIGN - 1) & ~(ITEM_ALIGN - 1))
+
+#define ElemOffset(map) AlignUp((map)->keySize)
+
+#define ItemSize(map) \
+	(sizeof(Item) + AlignUp(ElemOffset(map) + (map)->elemSize))
+
+#define ItemKey(item) ((void *)(item)->data)
+
+#define ItemElem(map, item) ((void *)((item)->data + ElemOffset(map)))
 
 
 
 /* ----- PRIVATE TYPES ----- */
 
+/*
+ * Every item lives in one of the map's item chunks, and each slot is just the
+ * index of the first item in its chain. Creating, expanding and destroying a
+ * map therefore allocates a constant number of blocks no matter how many
+ * slots it has. Each chunk is twice the size of the last, so adding items
+ * allocates a new chunk instead of moving every existing item.
+ */
 typedef struct Item {
-	unsigned int slotIdx;
-	unsigned int slotEntryIdx;
-	unsigned char elem[];
+	uint64_t hash;
+	size_t next;
+	unsigned char data[];
 } Item;
 
-typedef struct SlotEntry {
-	unsigned int itemIdx;
-	unsigned char key[];
-} SlotEntry;
+/*
+ * In Robin Hood mode, slots are cells which refer to items directly. The upper
+ * half of the item's hash is kept alongside its index so most mismatches are
+ * rejected without touching the item.
+ */
+typedef struct Cell {
+	uint32_t dist; /* Probe distance plus one (0 for empty cells). */
+	uint32_t tag;
+	size_t itemIdx;
+} Cell;
 
 
 
 /* ----- PRIVATE FUNCTIONS ----- */
 
-static inline float LoadFactor(FoxMap * map, int itemAddend) {
-	return (float)(FoxArraySize(&map->items) + itemAddend)
+static inline Item * ItemAt(
+		FoxMap * map,
+		size_t itemIdx
+) {
+	assert(itemIdx < map->numItems);
+	size_t chunkIdx = (
+			sizeof(size_t) * 8 - 1
+			- __builtin_clzl((itemIdx >> ITEM_CHUNK_SHIFT) + 1)
+	);
+	size_t offset = itemIdx - ChunkStart(chunkIdx);
+
+	return (Item *)(map->itemChunks[chunkIdx] + offset * map->itemSize);
+}
+
+/*
+ * Allocate item chunks until there is room for numItems items.
+ */
+static void ReserveItems(
+		FoxMap * map,
+		size_t numItems
+) {
+	while (ChunkStart(map->numItemChunks) < numItems) {
+		size_t chunkIdx = map->numItemChunks++;
+		map->itemChunks = realloc(
+				map->itemChunks,
+				map->numItemChunks * sizeof(unsigned char *)
+		);
+		assert(map->itemChunks);
+		map->itemChunks[chunkIdx] = malloc(
+				(ChunkStart(chunkIdx + 1) - ChunkStart(chunkIdx))
+				* map->itemSize
+		);
+		assert(map->itemChunks[chunkIdx]);
+	}
+
+	return;
+}
+
+/*
+ * Free every item chunk (other than the first) which holds no items.
+ */
+static void ShrinkItems(FoxMap * map) {
+	size_t numItemChunks = map->numItemChunks;
+	while (
+			numItemChunks > 1
+			&& ChunkStart(numItemChunks - 1) >= map->numItems
+	) {
+		free(map->itemChunks[--numItemChunks]);
+	}
+	map->numItemChunks = numItemChunks;
+
+	return;
+}
+
+static inline Item * ItemPush(FoxMap * map) {
+	ReserveItems(map, map->numItems + 1);
+
+	return ItemAt(map, map->numItems++);
+}
+
+static inline float LoadFactor(FoxMap * map, size_t itemAddend) {
+	return (float)(map->numItems + itemAddend)
 		/ (float)FoxArraySize(&map->slots);
 }
 
-static inline bool ItemLookup(
+static inline bool Migrating(FoxMap * map) {
+	return !FoxArrayEmpty(&map->oldSlots);
+}
+
+/*
+ * Allocate a table of numSlots slots without initializing them.
+ */
+static void AllocSlots(
+		FoxArray * slots,
+		size_t numSlots
+) {
+	FoxArrayInit(
+			slots,
+			sizeof(size_t),
+			numSlots,
+			FOXARRAY_DEF_GROWRATE
+	);
+	slots->size = numSlots;
+
+	return;
+}
+
+static void InitSlots(
+		FoxArray * slots,
+		size_t numSlots
+) {
+	AllocSlots(slots, numSlots);
+	memset(slots->elems, 0xff, numSlots * sizeof(size_t)); /* NULL_ITEM. */
+
+	return;
+}
+
+/*
+ * Get the slot which holds (or would hold) a key with the provided hash. Old
+ * slots which have not been migrated yet still hold their keys.
+ */
+static inline size_t * HashSlot(
+		FoxMap * map,
+		uint64_t hash
+) {
+	if (Migrating(map)) {
+		size_t oldSlotIdx = hash & map->oldSlotIdxMask;
+		if (oldSlotIdx >= map->migrateIdx) {
+			return FoxArrayIndex(&map->oldSlots, oldSlotIdx);
+		}
+	}
+
+	return FoxArrayIndex(&map->slots, hash & map->slotIdxMask);
+}
+
+/*
+ * Get the link (either a slot or the previous item's next index) which refers
+ * to an item.
+ */
+static inline size_t * ItemLink(
+		FoxMap * map,
+		size_t itemIdx
+) {
+	Item * item = ItemAt(map, itemIdx);
+	size_t * link = HashSlot(map, item->hash);
+	while (*link != itemIdx) {
+		link = &ItemAt(map, *link)->next;
+	}
+
+	return link;
+}
+
+static void InitCells(
+		FoxArray * cells,
+		size_t numCells
+) {
+	FoxArrayInit(
+			cells,
+			sizeof(Cell),
+			numCells,
+			FOXARRAY_DEF_GROWRATE
+	);
+	cells->size = numCells;
+	memset(cells->elems, 0, numCells * sizeof(Cell));
+
+	return;
+}
+
+/*
+ * Place an item into the cell table, displacing any item which is closer to
+ * its home cell than the item being placed (and then placing that item in
+ * turn).
+ */
+static void CellPlace(
+		FoxMap * map,
+		size_t itemIdx,
+		uint64_t hash
+) {
+	Cell * cells = (Cell *)map->slots.elems;
+	size_t cellIdxMask = map->slotIdxMask;
+	Cell cell = {.dist = 1, .tag = hash >> 32, .itemIdx = itemIdx};
+
+	for (size_t idx = hash & cellIdxMask; ; idx = (idx + 1) & cellIdxMask) {
+		Cell * other = cells + idx;
+		if (other->dist == 0) {
+			*other = cell;
+			break;
+		}
+		if (other->dist < cell.dist) {
+			Cell tmp = *other;
+			*other = cell;
+			cell = tmp;
+		}
+		cell.dist++;
+	}
+
+	return;
+}
+
+/*
+ * Get the cell which refers to a key's item (or NULL if it is not present).
+ * Probing stops as soon as it reaches a cell closer to its home than the key
+ * would be.
+ */
+static inline Cell * CellLookup(
 		FoxMap * map,
 		const void * key,
-		unsigned int * slotIdx,
-		unsigned int * slotEntryIdx,
-		unsigned int * itemIdx
+		uint64_t hash,
+		int (* keyCompare)(const void *, const void *)
 ) {
-	bool exists = false;
-	int (* keyCompare)(const void *, const void *) = map->keyCompare;
-	unsigned int (* keyHash)(const void *) = map->keyHash;
+	Cell * cells = (Cell *)map->slots.elems;
+	size_t cellIdxMask = map->slotIdxMask;
+	uint32_t tag = hash >> 32;
+
+	size_t idx = hash & cellIdxMask;
+	for (uint32_t dist = 1; cells[idx].dist >= dist; dist++) {
+		Cell * cell = cells + idx;
+		if (cell->tag == tag) {
+			Item * item = ItemAt(map, cell->itemIdx);
+			if (item->hash == hash) {
+				int diff = (
+						(keyCompare) ?
+						keyCompare(key, ItemKey(item))
+						: memcmp(key, ItemKey(item), map->keySize)
+				);
+				if (diff == 0) return cell;
+			}
+		}
+		idx = (idx + 1) & cellIdxMask;
+	}
+
+	return NULL;
+}
+
+/*
+ * Get the cell which refers to an item.
+ */
+static inline Cell * ItemCell(
+		FoxMap * map,
+		size_t itemIdx
+) {
+	Cell * cells = (Cell *)map->slots.elems;
+	size_t cellIdxMask = map->slotIdxMask;
+	Item * item = ItemAt(map, itemIdx);
+
+	size_t idx = item->hash & cellIdxMask;
+	while (cells[idx].itemIdx != itemIdx || cells[idx].dist == 0) {
+		idx = (idx + 1) & cellIdxMask;
+	}
+
+	return cells + idx;
+}
+
+/*
+ * Empty a cell by shifting each following displaced cell back by one, which
+ * leaves the table exactly as if the removed item had never been placed.
+ */
+static void CellRemove(
+		FoxMap * map,
+		Cell * cell
+) {
+	Cell * cells = (Cell *)map->slots.elems;
+	size_t cellIdxMask = map->slotIdxMask;
+
+	size_t idx = cell - cells;
+	size_t nextIdx = (idx + 1) & cellIdxMask;
+	while (cells[nextIdx].dist > 1) {
+		cells[idx] = cells[nextIdx];
+		cells[idx].dist--;
+		idx = nextIdx;
+		nextIdx = (nextIdx + 1) & cellIdxMask;
+	}
+	cells[idx] = (Cell){0};
+
+	return;
+}
+
+/*
+ * Replace the slot table with a table of numSlots cells (or chains) and
+ * re-place every item using its cached hash.
+ */
+static void Rebuild(
+		FoxMap * map,
+		size_t numSlots
+) {
+	size_t numItems = map->numItems;
+
+	FoxArrayDeinit(&map->slots);
+	map->slotIdxMask = numSlots - 1;
+	if (map->robinHood) {
+		InitCells(&map->slots, numSlots);
+		for (size_t idx = 0; idx < numItems; idx++) {
+			CellPlace(map, idx, ItemAt(map, idx)->hash);
+		}
+	} else {
+		InitSlots(&map->slots, numSlots);
+		for (size_t idx = 0; idx < numItems; idx++) {
+			Item * item = ItemAt(map, idx);
+			size_t * slot = FoxArrayIndex(
+					&map->slots,
+					item->hash & map->slotIdxMask
+			);
+			item->next = *slot;
+			*slot = idx;
+		}
+	}
+
+	return;
+}
+
+/*
+ * When growing, each new slot only receives items from the one old slot its
+ * index masks down to, so MigrateSlots() initializes new slots alongside the
+ * old slots they belong to instead of all of them being initialized up front.
+ */
+static void BeginResize(
+		FoxMap * map,
+		size_t numSlots
+) {
+	map->oldSlots = map->slots;
+	map->oldSlotIdxMask = map->slotIdxMask;
+	map->migrateIdx = 0;
+	if (numSlots >= FoxArraySize(&map->oldSlots)) {
+		AllocSlots(&map->slots, numSlots);
+	} else {
+		InitSlots(&map->slots, numSlots);
+	}
+	map->slotIdxMask = numSlots - 1;
+
+	return;
+}
+
+static inline size_t GrownSlots(FoxMap * map) {
+	return FoxRoundUpPow2((size_t)(FoxArraySize(&map->slots) * map->growRate));
+}
+
+static void BeginExpansion(FoxMap * map) {
+	BeginResize(map, GrownSlots(map));
 
-	/* Hash key to get slot index. */
-	unsigned int hash = (
-			(keyHash) ?
-			keyHash(key)
-			: FoxHashMem(key, map->keySize)
+	return;
+}
+
+/*
+ * Relink the chains of up to numSlots old slots into new slots using their
+ * cached hashes. Neither keyHash nor keyCopy is called, and items never move.
+ */
+static void MigrateSlots(
+		FoxMap * map,
+		size_t numSlots
+) {
+	FoxArray * oldSlots = &map->oldSlots;
+	size_t numOldSlots = FoxArraySize(oldSlots);
+	size_t numNewSlots = FoxArraySize(&map->slots);
+	size_t endIdx = map->migrateIdx + FoxMin(
+			numSlots,
+			numOldSlots - map->migrateIdx
 	);
-	unsigned int tmpSlotIdx = hash & map->slotIdxMask;
-
-	FoxArray * slot = FoxArrayIndex(&map->slots, tmpSlotIdx);
-	size_t numSlotEntries = FoxArraySize(slot);
-	for (unsigned int idx = 0; idx < numSlotEntries; idx++) {
-		SlotEntry * slotEntry = FoxArrayIndex(slot, idx);
-
-		/* Compare keys. */
-		int diff = (
-				(keyCompare) ?
-				keyCompare(key, slotEntry->key)
-				: memcmp(key, slotEntry->key, map->keySize)
+
+	for (size_t oldIdx = map->migrateIdx; oldIdx < endIdx; oldIdx++) {
+		/* Initialize the new slots which this old slot's items map to. */
+		if (numNewSlots >= numOldSlots) {
+			size_t * newSlots = (size_t *)map->slots.elems;
+			for (size_t idx = oldIdx; idx < numNewSlots; idx += numOldSlots) {
+				newSlots[idx] = NULL_ITEM;
+			}
+		}
+
+		size_t itemIdx = *(size_t *)FoxArrayIndex(oldSlots, oldIdx);
+		while (itemIdx != NULL_ITEM) {
+			Item * item = ItemAt(map, itemIdx);
+			size_t nextIdx = item->next;
+			size_t * slot = FoxArrayIndex(
+					&map->slots,
+					item->hash & map->slotIdxMask
+			);
+			item->next = *slot;
+			*slot = itemIdx;
+			itemIdx = nextIdx;
+		}
+	}
+	map->migrateIdx = endIdx;
+
+	/* Release old slots once they have all been migrated. */
+	if (endIdx == numOldSlots) {
+		FoxArrayDeinit(oldSlots);
+		map->oldSlotIdxMask = 0;
+		map->migrateIdx = 0;
+	}
+
+	return;
+}
+
+static inline void MigrateStep(FoxMap * map) {
+	if (Migrating(map)) MigrateSlots(map, map->migrateRate);
+
+	return;
+}
+
+/*
+ * Rebuild the slot table with numSlots slots in one pass.
+ */
+static void Resize(
+		FoxMap * map,
+		size_t numSlots
+) {
+	if (map->robinHood) {
+		Rebuild(map, numSlots);
+	} else {
+		if (Migrating(map)) MigrateSlots(map, SIZE_MAX);
+		BeginResize(map, numSlots);
+		MigrateSlots(map, SIZE_MAX);
+	}
+
+	return;
+}
+
+/*
+ * Get the smallest number of slots which can hold numItems items without
+ * reaching the load factor threshold.
+ */
+static size_t RequiredSlots(
+		FoxMap * map,
+		size_t numItems
+) {
+	float lfThresh = map->lfThresh;
+	size_t numSlots = FoxRoundUpPow2((size_t)(numItems / lfThresh));
+	while ((float)numItems / (float)numSlots >= lfThresh) numSlots *= 2;
+
+	return numSlots;
+}
+
+/*
+ * Perform the migration work of numOps individual operations at once.
+ */
+static inline void MigrateSteps(
+		FoxMap * map,
+		size_t numOps
+) {
+	if (Migrating(map)) {
+		size_t migrateRate = map->migrateRate;
+		MigrateSlots(
+				map,
+				(migrateRate > SIZE_MAX / numOps) ?
+				SIZE_MAX
+				: migrateRate * numOps
 		);
-		if ((exists = (diff == 0))) {
-			if (slotEntryIdx) *slotEntryIdx = idx;
-			if (itemIdx) *itemIdx = slotEntry->itemIdx;
-			break;
+	}
+
+	return;
+}
+
+/*
+ * Expand map if inserting numItems more items would reach the load factor
+ * threshold.
+ */
+static void ExpandFor(
+		FoxMap * map,
+		size_t numItems
+) {
+	float lfThresh = map->lfThresh;
+	if (lfThresh <= 0.0f || LoadFactor(map, numItems) < lfThresh) return;
+
+	if (map->migrateRate == 0 || map->robinHood) {
+		do {
+			FoxMapExpand(map);
+		} while (LoadFactor(map, numItems) >= lfThresh);
+	} else {
+		if (Migrating(map)) MigrateSlots(map, SIZE_MAX);
+		BeginExpansion(map);
+	}
+
+	return;
+}
+
+static inline uint64_t KeyHash(
+		FoxMap * map,
+		const void * key
+) {
+	if (map->keyedHash) {
+		uint64_t (* keyHashKeyed)(const void *, const FoxHashKey *) = (
+				map->keyHashKeyed
+		);
+		if (keyHashKeyed) return keyHashKeyed(key, &map->hashKey);
+
+		return FoxHashMemKeyed(key, map->keySize, &map->hashKey);
+	}
+
+	uint64_t (* keyHashSeeded)(const void *, uint64_t) = map->keyHashSeeded;
+	uint64_t (* keyHash64)(const void *) = map->keyHash64;
+	unsigned int (* keyHash)(const void *) = map->keyHash;
+
+	if (keyHashSeeded) return keyHashSeeded(key, map->hashKey.k0);
+	if (keyHash64) return keyHash64(key);
+	if (keyHash) return keyHash(key);
+
+	return FoxHashKeySeeded(key, map->keySize, map->hashKey.k0);
+}
+
+/*
+ * Get the link which refers to a key's item (or the link terminating the
+ * key's chain if it is not present).
+ */
+static inline size_t * ItemLookup(
+		FoxMap * map,
+		const void * key,
+		uint64_t hash,
+		int (* keyCompare)(const void *, const void *)
+) {
+	size_t * link = HashSlot(map, hash);
+	while (*link != NULL_ITEM) {
+		Item * item = ItemAt(map, *link);
+
+		/* Only compare keys whose cached hashes match. */
+		if (item->hash == hash) {
+			int diff = (
+					(keyCompare) ?
+					keyCompare(key, ItemKey(item))
+					: memcmp(key, ItemKey(item), map->keySize)
+			);
+			if (diff == 0) break;
+		}
+		link = &item->next;
+	}
+
+	return link;
+}
+
+/*
+ * Get the index of a key's item (or NULL_ITEM if it is not present).
+ */
+static inline size_t ItemFind(
+		FoxMap * map,
+		const void * key,
+		uint64_t hash,
+		int (* keyCompare)(const void *, const void *)
+) {
+	if (map->robinHood) {
+		Cell * cell = CellLookup(map, key, hash, keyCompare);
+		return (cell) ? cell->itemIdx : NULL_ITEM;
+	}
+
+	return *ItemLookup(map, key, hash, keyCompare);
+}
+
+static void * ItemCreate(
+		FoxMap * map,
+		const void * key,
+		uint64_t hash
+) {
+	assert(ItemFind(map, key, hash, map->keyCompare) == NULL_ITEM);
+
+	/* Create item. */
+	size_t itemIdx = map->numItems;
+	Item * item = ItemPush(map);
+	item->hash = hash;
+
+	/* Copy key. */
+	void (* keyCopy)(void *, const void *) = map->keyCopy;
+	if (map->keyArena) {
+		map->keyArenaCopy(ItemKey(item), key, map->keyArena);
+	} else if (keyCopy) {
+		keyCopy(ItemKey(item), key);
+	} else {
+		memcpy(ItemKey(item), key, map->keySize);
+	}
+
+	/* Place item in cell table or link it at head of slot chain. */
+	if (map->robinHood) {
+		CellPlace(map, itemIdx, hash);
+	} else {
+		size_t * slot = HashSlot(map, hash);
+		item->next = *slot;
+		*slot = itemIdx;
+	}
+
+	/* Initialize target element. */
+	void * elem = ItemElem(map, item);
+	memset(elem, 0, map->elemSize);
+
+	return elem;
+}
+
+/*
+ * Prefetch the slots of a batch of keys and then the first items of their
+ * chains so that the cache misses of every key overlap instead of each lookup
+ * stalling in turn.
+ */
+static void PrefetchSlots(
+		FoxMap * map,
+		const unsigned char * keys,
+		size_t numKeys,
+		uint64_t * hashes
+) {
+	if (map->robinHood) {
+		Cell * cells[BATCH_SIZE];
+		for (size_t idx = 0; idx < numKeys; idx++) {
+			uint64_t hash = KeyHash(map, keys + idx * map->keySize);
+			hashes[idx] = hash;
+			cells[idx] = FoxArrayIndex(&map->slots, hash & map->slotIdxMask);
+			__builtin_prefetch(cells[idx]);
+		}
+		for (size_t idx = 0; idx < numKeys; idx++) {
+			Cell * cell = cells[idx];
+			if (cell->dist != 0) {
+				__builtin_prefetch(ItemAt(map, cell->itemIdx));
+			}
 		}
+
+		return;
 	}
 
-	if (slotIdx) *slotIdx = tmpSlotIdx;
+	size_t * slots[BATCH_SIZE];
+	for (size_t idx = 0; idx < numKeys; idx++) {
+		hashes[idx] = KeyHash(map, keys + idx * map->keySize);
+		slots[idx] = HashSlot(map, hashes[idx]);
+		__builtin_prefetch(slots[idx]);
+	}
+	for (size_t idx = 0; idx < numKeys; idx++) {
+		size_t itemIdx = *slots[idx];
+		if (itemIdx != NULL_ITEM) {
+			__builtin_prefetch(ItemAt(map, itemIdx));
+		}
+	}
 
-	return exists;
+	return;
 }
 
 
@@ -136,6 +728,63 @@ void FoxMapInit(
 		int (* keyCompare)(const void * keyA, const void * keyB),
 		void (* keyCopy)(void *, const void *),
 		void (* keyDeinit)(void *)
+) {
+	FoxMapInit64(
+			map,
+			keySize,
+			elemSize,
+			initSlots,
+			growRate,
+			lfThresh,
+			NULL,
+			keyCompare,
+			keyCopy,
+			keyDeinit
+	);
+	map->keyHash = keyHash;
+
+	return;
+}
+
+FoxMap * FoxMapNew64(
+		size_t keySize,
+		size_t elemSize,
+		size_t initSlots,
+		float growRate,
+		float lfThresh,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void *, const void *),
+		void (* keyDeinit)(void *)
+) {
+	FoxMap * map = calloc(1, sizeof(FoxMap));
+	FoxMapInit64(
+			map,
+			keySize,
+			elemSize,
+			initSlots,
+			growRate,
+			lfThresh,
+			keyHash,
+			keyCompare,
+			keyCopy,
+			keyDeinit
+	);
+
+	return map;
+}
+
+void FoxMapInit64(
+		FoxMap * map,
+		size_t keySize,
+		size_t elemSize,
+		size_t initSlots,
+		float growRate,
+		float lfThresh,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void *, const void *),
+		void (* keyDeinit)(void *)
 ) {
 	assert(map);
 	assert(keySize > 0);
@@ -155,35 +804,32 @@ void FoxMapInit(
 	map->slotIdxMask = numSlots - 1;
 
 	/* Initialize key functions. */
-	map->keyHash = keyHash;
+	map->keyHash = NULL;
+	map->keyHash64 = keyHash;
+	map->keyHashSeeded = NULL;
+	map->keyHashKeyed = NULL;
+	FoxHashKeyRandom(&map->hashKey);
+	map->keyedHash = false;
 	map->keyCompare = keyCompare;
 	map->keyCopy = keyCopy;
 	map->keyDeinit = keyDeinit;
+	map->keyArena = NULL;
+	map->keyArenaCopy = NULL;
 
 	/* Initialize slots. */
-	FoxArray * slots = &map->slots;
-	FoxArrayInit(
-			slots,
-			sizeof(FoxArray),
-			numSlots,
-			FOXARRAY_DEF_GROWRATE
-	);
-	for (unsigned int idx = 0; idx < numSlots; idx++) {
-		FoxArrayInit(
-				FoxArrayInsert(slots, idx),
-				SlotEntrySize(map),
-				4,
-				FOXARRAY_DEF_GROWRATE
-		);
-	}
+	InitSlots(&map->slots, numSlots);
+	map->oldSlots = (FoxArray){0};
+	map->oldSlotIdxMask = 0;
+	map->migrateIdx = 0;
+	map->migrateRate = 0;
+	map->robinHood = false;
 
 	/* Initialize items. */
-	FoxArrayInit(
-			&map->items,
-			ItemSize(map),
-			FOXARRAY_DEF_INITCAP,
-			FOXARRAY_DEF_GROWRATE
-	);
+	map->itemChunks = NULL;
+	map->numItemChunks = 0;
+	map->numItems = 0;
+	map->itemSize = ItemSize(map);
+	ReserveItems(map, 1);
 
 	return;
 }
@@ -191,22 +837,21 @@ void FoxMapInit(
 void FoxMapDeinit(FoxMap * map) {
 	assert(map);
 
-	FoxArray * slots = &map->slots;
-	size_t numSlots = FoxArraySize(slots);
 	void (* keyDeinit)(void *) = map->keyDeinit;
-	for (unsigned int slotIdx = 0; slotIdx < numSlots; slotIdx++) {
-		FoxArray * slot = FoxArrayIndex(slots, slotIdx);
-		if (keyDeinit) {
-			size_t numEntries = FoxArraySize(slot);
-			for (unsigned int entryIdx = 0; entryIdx < numEntries; entryIdx++) {
-				SlotEntry * slotEntry = FoxArrayIndex(slot, entryIdx);
-				keyDeinit(slotEntry->key);
-			}
+	if (map->keyArena) {
+		FoxArenaFree(map->keyArena);
+	} else if (keyDeinit) {
+		size_t numItems = map->numItems;
+		for (size_t idx = 0; idx < numItems; idx++) {
+			keyDeinit(ItemKey(ItemAt(map, idx)));
 		}
-		FoxArrayDeinit(slot);
 	}
-	FoxArrayDeinit(slots);
-	FoxArrayDeinit(&map->items);
+	FoxArrayDeinit(&map->slots);
+	if (Migrating(map)) FoxArrayDeinit(&map->oldSlots);
+	for (size_t idx = 0; idx < map->numItemChunks; idx++) {
+		free(map->itemChunks[idx]);
+	}
+	free(map->itemChunks);
 	*map = (FoxMap){0};
 
 	return;
@@ -215,126 +860,323 @@ void FoxMapDeinit(FoxMap * map) {
 size_t FoxMapSize(FoxMap * map) {
 	assert(map);
 
-	return FoxArraySize(&map->items);
+	return map->numItems;
 }
 
 bool FoxMapEmpty(FoxMap * map) {
 	assert(map);
 
-	return FoxArraySize(&map->items) == 0;
+	return map->numItems == 0;
 }
 
 float FoxMapLoadFactor(FoxMap * map) {
 	return LoadFactor(map, 0);
 }
 
-void FoxMapExpand(FoxMap * map) {
+void FoxMapSetMigrateRate(
+		FoxMap * map,
+		size_t migrateRate
+) {
 	assert(map);
 
-	FoxArray * slots = &map->slots;
-	size_t numSlots = FoxArraySize(slots);
-	FoxArray * items = &map->items;
-	size_t numItems = FoxArraySize(items);
-	size_t elemSize = map->elemSize;
+	map->migrateRate = migrateRate;
+	if (migrateRate == 0 && Migrating(map)) MigrateSlots(map, SIZE_MAX);
 
-	/* Initialize new map. */
-	FoxMap new = (FoxMap){0};
-	FoxMapInit(
-			&new,
-			map->keySize,
-			elemSize,
-			(size_t)(numSlots * map->growRate),
-			map->growRate,
-			map->lfThresh,
-			map->keyHash,
-			map->keyCompare,
-			map->keyCopy,
-			map->keyDeinit
+	return;
+}
+
+bool FoxMapMigrating(FoxMap * map) {
+	assert(map);
+
+	return Migrating(map);
+}
+
+void FoxMapSetRobinHood(
+		FoxMap * map,
+		bool robinHood
+) {
+	assert(map);
+
+	if (Migrating(map)) MigrateSlots(map, SIZE_MAX);
+	size_t numSlots = FoxArraySize(&map->slots);
+	map->robinHood = robinHood;
+	if (robinHood) {
+		float lfThresh = map->lfThresh;
+		if (lfThresh <= 0.0f || lfThresh >= 1.0f) {
+			map->lfThresh = FOXMAP_DEF_ROBINHOOD_LFTHRESH;
+		}
+		numSlots = FoxMax(numSlots, RequiredSlots(map, FoxMapSize(map)));
+	}
+	Rebuild(map, numSlots);
+
+	return;
+}
+
+bool FoxMapRobinHood(FoxMap * map) {
+	assert(map);
+
+	return map->robinHood;
+}
+
+void FoxMapSetSeededHash(
+		FoxMap * map,
+		uint64_t (* keyHashSeeded)(const void * key, uint64_t seed),
+		uint64_t (* keyHashKeyed)(const void * key, const FoxHashKey * hashKey)
+) {
+	assert(map);
+	assert(keyHashSeeded);
+	assert(FoxMapEmpty(map));
+
+	map->keyHashSeeded = keyHashSeeded;
+	map->keyHashKeyed = keyHashKeyed;
+
+	return;
+}
+
+void FoxMapSetKeyedHash(
+		FoxMap * map,
+		bool keyedHash
+) {
+	assert(map);
+	assert(FoxMapEmpty(map));
+	assert(
+			!keyedHash
+			|| map->keyHashKeyed
+			|| (!map->keyHashSeeded && !map->keyHash64 && !map->keyHash)
 	);
 
-	/* Copy key-element pairs to new map. */
-	for (unsigned int idx = 0; idx < numItems; idx++) {
-		Item * item = FoxArrayIndex(items, idx);
-		FoxArray * slot = FoxArrayIndex(slots, item->slotIdx);
-		SlotEntry * slotEntry = FoxArrayIndex(slot, item->slotEntryIdx);
-		
-		memcpy(
-				FoxMapInsert(&new, slotEntry->key),
-				item->elem,
-				elemSize
-		);
+	map->keyedHash = keyedHash;
+
+	return;
+}
+
+bool FoxMapKeyedHash(FoxMap * map) {
+	assert(map);
+
+	return map->keyedHash;
+}
+
+void FoxMapSetKeyArena(
+		FoxMap * map,
+		void (* keyCopy)(void * copy, const void * key, FoxArena * arena),
+		size_t chunkSize
+) {
+	assert(map);
+	assert(keyCopy);
+	assert(FoxMapEmpty(map));
+	assert(!map->keyArena);
+
+	map->keyArena = FoxArenaNew(chunkSize);
+	map->keyArenaCopy = keyCopy;
+
+	return;
+}
+
+void FoxMapExpand(FoxMap * map) {
+	assert(map);
+
+	if (map->robinHood) {
+		Rebuild(map, GrownSlots(map));
+		return;
 	}
 
-	/* De-initialize old map. */
-	FoxMapDeinit(map);
+	if (Migrating(map)) MigrateSlots(map, SIZE_MAX);
+	BeginExpansion(map);
+	MigrateSlots(map, SIZE_MAX);
+
+	return;
+}
+
+void FoxMapReserve(
+		FoxMap * map,
+		size_t numItems
+) {
+	assert(map);
 
-	/* Set new map. */
-	*map = new;
+	if (map->lfThresh > 0.0f) {
+		size_t numSlots = RequiredSlots(map, numItems);
+		if (numSlots > FoxArraySize(&map->slots)) Resize(map, numSlots);
+	}
+	ReserveItems(map, numItems);
 
 	return;
 }
 
+void FoxMapShrink(FoxMap * map) {
+	assert(map);
+
+	size_t numSlots = FoxArraySize(&map->slots);
+	if (map->lfThresh > 0.0f) {
+		numSlots = FoxMin(numSlots, RequiredSlots(map, FoxMapSize(map)));
+	}
+	Resize(map, numSlots);
+	ShrinkItems(map);
+
+	return;
+}
+
+uint64_t FoxMapKeyHash(
+		FoxMap * map,
+		const void * key
+) {
+	assert(map);
+	assert(key);
+
+	return KeyHash(map, key);
+}
+
 void * FoxMapIndex(
 		FoxMap * map,
 		const void * key
 ) {
 	assert(map);
 	assert(key);
+
+	return FoxMapIndexHashed(map, key, KeyHash(map, key));
+}
+
+void * FoxMapIndexHashed(
+		FoxMap * map,
+		const void * key,
+		uint64_t hash
+) {
+	assert(map);
+	assert(key);
 	void * elem = NULL;
 
-	unsigned int itemIdx;
-	if (ItemLookup(map, key, NULL, NULL, &itemIdx)) {
-		Item * item = FoxArrayIndex(&map->items, itemIdx);
-		elem = item->elem;
+	MigrateStep(map);
+	size_t itemIdx = ItemFind(map, key, hash, map->keyCompare);
+	if (itemIdx != NULL_ITEM) {
+		elem = ItemElem(map, ItemAt(map, itemIdx));
 	}
 
 	return elem;
 }
 
-void * FoxMapInsert(
+void * FoxMapIndexHashedCompare(
 		FoxMap * map,
-		const void * key
+		const void * key,
+		uint64_t hash,
+		int (* keyCompare)(const void *, const void *)
 ) {
 	assert(map);
 	assert(key);
+	assert(keyCompare);
+	void * elem = NULL;
 
-	/* Expand map if necessary. */
-	float lfThresh = map->lfThresh;
-	if (lfThresh > 0.0f && LoadFactor(map, 1) >= lfThresh) {
-		FoxMapExpand((FoxMap *)map);
+	MigrateStep(map);
+	size_t itemIdx = ItemFind(map, key, hash, keyCompare);
+	if (itemIdx != NULL_ITEM) {
+		elem = ItemElem(map, ItemAt(map, itemIdx));
 	}
 
-	/* Lookup slot. */
-	unsigned int slotIdx;
-	assert(!ItemLookup(map, key, &slotIdx, NULL, NULL));
-	FoxArray * slot = FoxArrayIndex(&map->slots, slotIdx);
+	return elem;
+}
 
-	/* Create slot entry. */
-	unsigned int slotEntryIdx = FoxArraySize(slot);
-	SlotEntry * slotEntry = FoxArrayInsert(slot, slotEntryIdx);
-	
-	/* Copy key. */
-	void (* keyCopy)(void *, const void *) = map->keyCopy;
-	if (keyCopy) {
-		keyCopy(slotEntry->key, key);
-	} else {
-		memcpy(slotEntry->key, key, map->keySize);
+void * FoxMapFindHashed(
+		FoxMap * map,
+		const void * key,
+		uint64_t hash
+) {
+	assert(map);
+	assert(key);
+	void * elem = NULL;
+
+	size_t itemIdx = ItemFind(map, key, hash, map->keyCompare);
+	if (itemIdx != NULL_ITEM) elem = ItemElem(map, ItemAt(map, itemIdx));
+
+	return elem;
+}
+
+void FoxMapIndexMany(
+		FoxMap * map,
+		const void * keys,
+		size_t numKeys,
+		void ** elems
+) {
+	assert(map);
+	assert(keys || numKeys == 0);
+	assert(elems || numKeys == 0);
+
+	const unsigned char * batchKeys = keys;
+	uint64_t hashes[BATCH_SIZE];
+	for (size_t batchIdx = 0; batchIdx < numKeys; batchIdx += BATCH_SIZE) {
+		size_t batchSize = FoxMin(BATCH_SIZE, numKeys - batchIdx);
+
+		MigrateSteps(map, batchSize);
+		PrefetchSlots(map, batchKeys, batchSize, hashes);
+		for (size_t idx = 0; idx < batchSize; idx++) {
+			void * elem = NULL;
+			size_t itemIdx = ItemFind(
+					map,
+					batchKeys,
+					hashes[idx],
+					map->keyCompare
+			);
+			if (itemIdx != NULL_ITEM) {
+				Item * item = ItemAt(map, itemIdx);
+				elem = ItemElem(map, item);
+			}
+			elems[batchIdx + idx] = elem;
+			batchKeys += map->keySize;
+		}
 	}
 
-	/* Create item. */
-	FoxArray * items = &map->items;
-	unsigned int itemIdx = FoxArraySize(items);
-	Item * item = FoxArrayInsert(items, itemIdx);
-	item->slotIdx = slotIdx;
-	item->slotEntryIdx = slotEntryIdx;
+	return;
+}
 
-	/* Update slot entry. */
-	slotEntry->itemIdx = itemIdx;
+void * FoxMapInsert(
+		FoxMap * map,
+		const void * key
+) {
+	assert(map);
+	assert(key);
 
-	/* Initialize target element. */
-	memset(item->elem, 0, map->elemSize);
+	return FoxMapInsertHashed(map, key, KeyHash(map, key));
+}
+
+void * FoxMapInsertHashed(
+		FoxMap * map,
+		const void * key,
+		uint64_t hash
+) {
+	assert(map);
+	assert(key);
+
+	/* Expand map if necessary. */
+	MigrateStep(map);
+	ExpandFor(map, 1);
+
+	return ItemCreate(map, key, hash);
+}
+
+void FoxMapInsertMany(
+		FoxMap * map,
+		const void * keys,
+		size_t numKeys,
+		void ** elems
+) {
+	assert(map);
+	assert(keys || numKeys == 0);
+	assert(elems || numKeys == 0);
+
+	const unsigned char * batchKeys = keys;
+	uint64_t hashes[BATCH_SIZE];
+	for (size_t batchIdx = 0; batchIdx < numKeys; batchIdx += BATCH_SIZE) {
+		size_t batchSize = FoxMin(BATCH_SIZE, numKeys - batchIdx);
+
+		/* Expand map up front so that prefetched slots remain valid. */
+		MigrateSteps(map, batchSize);
+		ExpandFor(map, batchSize);
+
+		PrefetchSlots(map, batchKeys, batchSize, hashes);
+		for (size_t idx = 0; idx < batchSize; idx++) {
+			elems[batchIdx + idx] = ItemCreate(map, batchKeys, hashes[idx]);
+			batchKeys += map->keySize;
+		}
+	}
 
-	return item->elem;
+	return;
 }
 
 void FoxMapRemove(
@@ -345,54 +1187,53 @@ void FoxMapRemove(
 	assert(map);
 	assert(key);
 
-	unsigned int slotIdx, slotEntryIdx, itemIdx;
-	assert(ItemLookup(map, key, &slotIdx, &slotEntryIdx, &itemIdx));
-	FoxArray * slots = &map->slots;
-	FoxArray * items = &map->items;
-	FoxArray * slot = FoxArrayIndex(slots, slotIdx);
+	FoxMapRemoveHashed(map, key, KeyHash(map, key), elem);
 
-	/* Get item and slot entry to remove. */
-	SlotEntry * slotEntry = FoxArrayIndex(slot, slotEntryIdx);
-	Item * item = FoxArrayIndex(items, itemIdx);
-
-	/* Copy target element if requested. */
-	if (elem) memcpy(elem, item->elem, map->elemSize);
-
-	/* Remove item. */
-	unsigned int lastItemIdx = FoxArraySize(items) - 1;
-	if (itemIdx < lastItemIdx) {
-		/* Get last item and slot entry. */
-		Item * lastItem = FoxArrayIndex(items, lastItemIdx);
-		FoxArray * lastSlot = FoxArrayIndex(slots, lastItem->slotIdx);
-		SlotEntry * lastSlotEntry = FoxArrayIndex(
-				lastSlot,
-				lastItem->slotEntryIdx
-		);
+	return;
+}
 
-		/* Move last item. */
-		memcpy(item, lastItem, ItemSize(map));
+void FoxMapRemoveHashed(
+		FoxMap * map,
+		const void * key,
+		uint64_t hash,
+		void * elem
+) {
+	assert(map);
+	assert(key);
 
-		/* Update last slot entry. */
-		lastSlotEntry->itemIdx = itemIdx;
+	MigrateStep(map);
+	size_t itemIdx;
+	if (map->robinHood) {
+		Cell * cell = CellLookup(map, key, hash, map->keyCompare);
+		assert(cell);
+		itemIdx = cell->itemIdx;
+		CellRemove(map, cell);
+	} else {
+		size_t * link = ItemLookup(map, key, hash, map->keyCompare);
+		itemIdx = *link;
+		assert(itemIdx != NULL_ITEM);
+		*link = ItemAt(map, itemIdx)->next;
 	}
-	FoxArrayRemove(items, lastItemIdx, NULL);
+	Item * item = ItemAt(map, itemIdx);
 
-	/* Remove slot entry. */
-	void (* keyDeinit)(void *) = map->keyDeinit;
-	if (keyDeinit) keyDeinit(slotEntry->key);
-	unsigned int lastSlotEntryIdx = FoxArraySize(slot) - 1;
-	if (slotEntryIdx < lastSlotEntryIdx) {
-		/* Get last slot entry and item. */
-		SlotEntry * lastSlotEntry = FoxArrayIndex(slot, lastSlotEntryIdx);
-		Item * lastItem = FoxArrayIndex(items, lastSlotEntry->itemIdx);
+	/* Copy target element if requested. */
+	if (elem) memcpy(elem, ItemElem(map, item), map->elemSize);
 
-		/* Move last slot entry. */
-		memcpy(slotEntry, lastSlotEntry, SlotEntrySize(map));
+	/* De-initialize key. */
+	void (* keyDeinit)(void *) = map->keyDeinit;
+	if (keyDeinit && !map->keyArena) keyDeinit(ItemKey(item));
 
-		/* Update last item. */
-		lastItem->slotEntryIdx = slotEntryIdx;
+	/* Move last item into the hole. */
+	size_t lastItemIdx = map->numItems - 1;
+	if (itemIdx < lastItemIdx) {
+		if (map->robinHood) {
+			ItemCell(map, lastItemIdx)->itemIdx = itemIdx;
+		} else {
+			*ItemLink(map, lastItemIdx) = itemIdx;
+		}
+		memcpy(item, ItemAt(map, lastItemIdx), map->itemSize);
 	}
-	FoxArrayRemove(slot, lastSlotEntryIdx, NULL);
+	map->numItems--;
 
 	return;
 }
@@ -405,14 +1246,10 @@ void FoxMapForEachPair(
 	assert(map);
 	assert(callback);
 
-	FoxArray * slots = &map->slots;
-	FoxArray * items = &map->items;
-	size_t numItems = FoxArraySize(items);
-	for (unsigned int idx = 0; idx < numItems; idx++) {
-		Item * item = FoxArrayIndex(items, idx);
-		FoxArray * slot = FoxArrayIndex(slots, item->slotIdx);
-		SlotEntry * slotEntry = FoxArrayIndex(slot, item->slotEntryIdx);
-		if (!callback(slotEntry->key, item->elem, ctx)) break;
+	size_t numItems = map->numItems;
+	for (size_t idx = 0; idx < numItems; idx++) {
+		Item * item = ItemAt(map, idx);
+		if (!callback(ItemKey(item), ItemElem(map, item), ctx)) break;
 	}
 
 	return;
@@ -426,11 +1263,10 @@ void FoxMapForEachElement(
 	assert(map);
 	assert(callback);
 
-	FoxArray * items = &map->items;
-	size_t numItems = FoxArraySize(items);
-	for (unsigned int idx = 0; idx < numItems; idx++) {
-		Item * item = FoxArrayIndex(items, idx);
-		if (!callback(item->elem, ctx)) break;
+	size_t numItems = map->numItems;
+	for (size_t idx = 0; idx < numItems; idx++) {
+		Item * item = ItemAt(map, idx);
+		if (!callback(ItemElem(map, item), ctx)) break;
 	}
 
 	return;
@@ -444,14 +1280,9 @@ void FoxMapForEachKey(
 	assert(map);
 	assert(callback);
 
-	FoxArray * slots = &map->slots;
-	FoxArray * items = &map->items;
-	size_t numItems = FoxArraySize(items);
-	for (unsigned int idx = 0; idx < numItems; idx++) {
-		Item * item = FoxArrayIndex(items, idx);
-		FoxArray * slot = FoxArrayIndex(slots, item->slotIdx);
-		SlotEntry * slotEntry = FoxArrayIndex(slot, item->slotEntryIdx);
-		if (!callback(slotEntry->key, ctx)) break;
+	size_t numItems = map->numItems;
+	for (size_t idx = 0; idx < numItems; idx++) {
+		if (!callback(ItemKey(ItemAt(map, idx)), ctx)) break;
 	}
 
 	return;
@@ -0,0 +1,460 @@
+/*
+ * Copyright 2020 Garrett Russell Fairburn
+ * 
+ * This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ */
+#include <assert.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "foxutils/mappedmap.h"
+#include "foxutils/math.h"
+
+
+
+/* ----- PRIVATE MACROS ----- */
+
+#define FILE_MAGIC 0x50414d584f46ull /* "FOXMAP" in little-endian. */
+
+#define FILE_VERSION 1u
+
+#define FLAG_STRING_KEYS 0x1u
+
+#define TMP_SUFFIX ".XXXXXX"
+
+#define FILE_MODE 0644
+
+/* Larger key or element sizes are rejected so slot sizes cannot overflow. */
+#define MAX_FIELD_SIZE (SIZE_MAX / 4)
+
+#define SLOT_ALIGN 8ul
+
+#define HASH_SEED 0x9e3779b97f4a7c15ull
+
+#define HASH_MUL_A 0xff51afd7ed558ccdull
+
+#define HASH_MUL_B 0xc4ceb9fe1a85ec53ull
+
+#define AlignUp(size) (((size) + SLOT_ALIGN - 1) & ~(SLOT_ALIGN - 1))
+
+/* Slots are marked as occupied by storing a tag which is never zero. */
+#define HashTag(hash) ((hash) | 1ull)
+
+#define SlotKey(slot) ((slot) + sizeof(uint64_t))
+
+#define SlotElem(slotKeySize, slot) \
+	((slot) + sizeof(uint64_t) + AlignUp(slotKeySize))
+
+
+
+/* ----- PRIVATE TYPES ----- */
+
+typedef struct Header {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t flags;
+	uint64_t keySize;
+	uint64_t elemSize;
+	uint64_t slotSize;
+	uint64_t numSlots;
+	uint64_t size;
+	uint64_t stringsSize;
+} Header;
+
+typedef struct StringRef {
+	uint64_t offset;
+	uint64_t length;
+} StringRef;
+
+typedef struct SaveCtx {
+	size_t keySize;
+	size_t elemSize;
+	size_t slotSize;
+	size_t numSlots;
+	unsigned char * slots;
+	char * strings;
+	size_t stringsSize;
+	size_t stringsCap;
+	bool stringKeys;
+} SaveCtx;
+
+
+
+/* ----- PRIVATE FUNCTIONS ----- */
+
+/*
+ * Part of the file format, so it must never change (unlike the functions of
+ * foxutils/hash.h).
+ */
+static uint64_t HashBytes(
+		const void * data,
+		size_t size
+) {
+	const unsigned char * bytes = data;
+	uint64_t hash = HASH_SEED ^ (size * HASH_MUL_A);
+
+	for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, bytes, sizeof(uint64_t));
+		bytes += sizeof(uint64_t);
+		hash = FoxRotL(hash ^ (word * HASH_MUL_B), 31) * HASH_MUL_A;
+	}
+	if (size > 0) {
+		uint64_t word = 0;
+		memcpy(&word, bytes, size);
+		hash = FoxRotL(hash ^ (word * HASH_MUL_B), 31) * HASH_MUL_A;
+	}
+
+	hash ^= hash >> 33;
+	hash *= HASH_MUL_B;
+	hash ^= hash >> 29;
+
+	return hash;
+}
+
+static size_t SlotKeySize(
+		size_t keySize,
+		bool stringKeys
+) {
+	return (stringKeys) ? sizeof(StringRef) : keySize;
+}
+
+static bool SavePair(
+		const void * key,
+		void * elem,
+		SaveCtx * ctx
+) {
+	size_t slotKeySize = SlotKeySize(ctx->keySize, ctx->stringKeys);
+	uint64_t hash;
+	StringRef ref;
+	if (ctx->stringKeys) {
+		const char * str = *(const char **)key;
+		ref = (StringRef){
+			.offset = ctx->stringsSize,
+			.length = strlen(str)
+		};
+		hash = HashBytes(str, ref.length);
+
+		/* Append string (including its terminator). */
+		size_t stringsSize = ctx->stringsSize + ref.length + 1;
+		if (stringsSize > ctx->stringsCap) {
+			ctx->stringsCap = FoxMax(stringsSize, ctx->stringsCap * 2);
+			ctx->strings = realloc(ctx->strings, ctx->stringsCap);
+			assert(ctx->strings);
+		}
+		memcpy(ctx->strings + ref.offset, str, ref.length + 1);
+		ctx->stringsSize = stringsSize;
+		key = &ref;
+	} else {
+		hash = HashBytes(key, ctx->keySize);
+	}
+
+	/* Find empty slot. */
+	size_t mask = ctx->numSlots - 1;
+	size_t slotIdx = hash & mask;
+	unsigned char * slot = ctx->slots + slotIdx * ctx->slotSize;
+	while (*(uint64_t *)slot != 0) {
+		slotIdx = (slotIdx + 1) & mask;
+		slot = ctx->slots + slotIdx * ctx->slotSize;
+	}
+
+	*(uint64_t *)slot = HashTag(hash);
+	memcpy(SlotKey(slot), key, slotKeySize);
+	memcpy(SlotElem(slotKeySize, slot), elem, ctx->elemSize);
+
+	return true;
+}
+
+/*
+ * Write to a temporary file in the same directory and then rename it over path,
+ * so that the file at path (which may be mapped) is replaced atomically and is
+ * never left partially written.
+ */
+static bool WriteFile(
+		const char * path,
+		const Header * header,
+		const SaveCtx * ctx
+) {
+	size_t pathLen = strlen(path);
+	char * tmpPath = malloc(pathLen + sizeof(TMP_SUFFIX));
+	assert(tmpPath);
+	memcpy(tmpPath, path, pathLen);
+	memcpy(tmpPath + pathLen, TMP_SUFFIX, sizeof(TMP_SUFFIX));
+
+	int fd = mkstemp(tmpPath);
+	FILE * file = (fd >= 0) ? fdopen(fd, "wb") : NULL;
+	if (!file) {
+		if (fd >= 0) {
+			close(fd);
+			unlink(tmpPath);
+		}
+		free(tmpPath);
+		return false;
+	}
+
+	bool success = (
+			fchmod(fd, FILE_MODE) == 0
+			&& fwrite(header, sizeof(Header), 1, file) == 1
+			&& fwrite(ctx->slots, ctx->slotSize, ctx->numSlots, file)
+				== ctx->numSlots
+			&& (
+				ctx->stringsSize == 0
+				|| fwrite(ctx->strings, ctx->stringsSize, 1, file) == 1
+			)
+			&& fflush(file) == 0
+			&& fsync(fd) == 0
+	);
+	success = (fclose(file) == 0) && success;
+	success = success && rename(tmpPath, path) == 0;
+	if (!success) unlink(tmpPath);
+	free(tmpPath);
+
+	return success;
+}
+
+static bool Save(
+		FoxMap * map,
+		const char * path,
+		bool stringKeys
+) {
+	size_t size = FoxMapSize(map);
+	size_t slotKeySize = SlotKeySize(map->keySize, stringKeys);
+	SaveCtx ctx = {
+		.keySize = map->keySize,
+		.elemSize = map->elemSize,
+		.slotSize = sizeof(uint64_t)
+			+ AlignUp(slotKeySize)
+			+ AlignUp(map->elemSize),
+		.numSlots = FoxRoundUpPow2(size + size / 2 + 1),
+		.stringKeys = stringKeys
+	};
+
+	/* Lay out slots. */
+	ctx.slots = calloc(ctx.numSlots, ctx.slotSize);
+	assert(ctx.slots);
+	FoxMapForEachPair(
+			map,
+			(bool (*)(const void *, void *, void *))&SavePair,
+			&ctx
+	);
+
+	/* Write file. */
+	Header header = {
+		.magic = FILE_MAGIC,
+		.version = FILE_VERSION,
+		.flags = (stringKeys) ? FLAG_STRING_KEYS : 0,
+		.keySize = ctx.keySize,
+		.elemSize = ctx.elemSize,
+		.slotSize = ctx.slotSize,
+		.numSlots = ctx.numSlots,
+		.size = size,
+		.stringsSize = ctx.stringsSize
+	};
+	bool success = WriteFile(path, &header, &ctx);
+
+	free(ctx.strings);
+	free(ctx.slots);
+
+	return success;
+}
+
+static bool ValidHeader(
+		const Header * header,
+		size_t fileSize
+) {
+	if (header->magic != FILE_MAGIC || header->version != FILE_VERSION) {
+		return false;
+	}
+
+	if (
+			header->keySize > MAX_FIELD_SIZE
+			|| header->elemSize > MAX_FIELD_SIZE
+	) {
+		return false;
+	}
+
+	bool stringKeys = header->flags & FLAG_STRING_KEYS;
+	size_t slotKeySize = SlotKeySize(header->keySize, stringKeys);
+	if (
+			header->keySize == 0
+			|| header->slotSize != sizeof(uint64_t)
+				+ AlignUp(slotKeySize)
+				+ AlignUp(header->elemSize)
+			|| header->numSlots == 0
+			|| (header->numSlots & (header->numSlots - 1)) != 0
+			|| header->size >= header->numSlots
+	) {
+		return false;
+	}
+
+	size_t bodySize = fileSize - sizeof(Header);
+	if (header->numSlots > bodySize / header->slotSize) return false;
+
+	return header->stringsSize
+		== bodySize - header->numSlots * header->slotSize;
+}
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+bool FoxMapSave(
+		FoxMap * map,
+		const char * path
+) {
+	assert(map);
+	assert(path);
+	assert(!map->keyCopy && !map->keyArena);
+	assert(!map->keyCompare);
+
+	return Save(map, path, false);
+}
+
+bool FoxStringMapSave(
+		FoxMap * map,
+		const char * path
+) {
+	assert(map);
+	assert(path);
+	assert(map->keySize == sizeof(const char *));
+
+	return Save(map, path, true);
+}
+
+FoxMappedMap * FoxMapOpenMapped(const char * path) {
+	FoxMappedMap * mapped = malloc(sizeof(FoxMappedMap));
+	assert(mapped);
+	if (!FoxMappedMapInit(mapped, path)) {
+		free(mapped);
+		return NULL;
+	}
+
+	return mapped;
+}
+
+void FoxMappedMapFree(FoxMappedMap * mapped) {
+	FoxMappedMapDeinit(mapped);
+	free(mapped);
+
+	return;
+}
+
+bool FoxMappedMapInit(
+		FoxMappedMap * mapped,
+		const char * path
+) {
+	assert(mapped);
+	assert(path);
+	*mapped = (FoxMappedMap){0};
+
+	/* Map file. */
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(Header)) {
+		close(fd);
+		return false;
+	}
+	size_t fileSize = info.st_size;
+	void * base = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) return false;
+
+	const Header * header = base;
+	if (!ValidHeader(header, fileSize)) {
+		munmap(base, fileSize);
+		return false;
+	}
+
+	bool stringKeys = header->flags & FLAG_STRING_KEYS;
+	const unsigned char * slots = (const unsigned char *)base + sizeof(Header);
+	*mapped = (FoxMappedMap){
+		.base = base,
+		.fileSize = fileSize,
+		.slots = slots,
+		.strings = (const char *)(slots + header->numSlots * header->slotSize),
+		.stringsSize = header->stringsSize,
+		.numSlots = header->numSlots,
+		.size = header->size,
+		.keySize = header->keySize,
+		.elemSize = header->elemSize,
+		.slotSize = header->slotSize,
+		.stringKeys = stringKeys
+	};
+
+	return true;
+}
+
+void FoxMappedMapDeinit(FoxMappedMap * mapped) {
+	assert(mapped);
+
+	if (mapped->base) munmap((void *)mapped->base, mapped->fileSize);
+	*mapped = (FoxMappedMap){0};
+
+	return;
+}
+
+size_t FoxMappedMapSize(FoxMappedMap * mapped) {
+	assert(mapped);
+
+	return mapped->size;
+}
+
+const void * FoxMappedMapIndex(
+		FoxMappedMap * mapped,
+		const void * key
+) {
+	assert(mapped);
+	assert(key);
+
+	bool stringKeys = mapped->stringKeys;
+	size_t slotKeySize = SlotKeySize(mapped->keySize, stringKeys);
+	const char * str = NULL;
+	size_t length = 0;
+	uint64_t hash;
+	if (stringKeys) {
+		str = *(const char **)key;
+		length = strlen(str);
+		hash = HashBytes(str, length);
+	} else {
+		hash = HashBytes(key, mapped->keySize);
+	}
+	uint64_t tag = HashTag(hash);
+
+	size_t mask = mapped->numSlots - 1;
+	size_t slotIdx = hash & mask;
+	for (size_t idx = 0; idx < mapped->numSlots; idx++) {
+		const unsigned char * slot = mapped->slots + slotIdx * mapped->slotSize;
+		uint64_t slotTag = *(const uint64_t *)slot;
+		if (slotTag == 0) break;
+
+		if (slotTag == tag) {
+			if (stringKeys) {
+				StringRef ref;
+				memcpy(&ref, SlotKey(slot), sizeof(StringRef));
+				if (
+						ref.length == length
+						&& ref.offset < mapped->stringsSize
+						&& length <= mapped->stringsSize - ref.offset
+						&& memcmp(mapped->strings + ref.offset, str, length)
+						== 0
+				) {
+					return SlotElem(slotKeySize, slot);
+				}
+			} else if (memcmp(SlotKey(slot), key, mapped->keySize) == 0) {
+				return SlotElem(slotKeySize, slot);
+			}
+		}
+
+		slotIdx = (slotIdx + 1) & mask;
+	}
+
+	return NULL;
+}
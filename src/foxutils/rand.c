@@ -5,12 +5,20 @@
  * under Apache 2.0. See file LICENSE for full license details.
  */
 #include <assert.h>
+#include <string.h>
 
 #include "foxutils/math.h"
 #include "foxutils/rand.h"
 
 
 
+/* ----- PRIVATE MACROS ----- */
+
+/* Number of values produced at a time when converting them. */
+#define FILL_CHUNK_SIZE 256
+
+
+
 /* ----- PUBLIC FUNCTIONS ----- */
 
 void FoxRandSeed(
@@ -104,3 +112,88 @@ double FoxRandDoubleRange(
 
 	return FoxRandDouble(prng) * (max - min) + min;
 }
+
+void FoxRandFillU64(
+		FoxPRNG * prng,
+		uint64_t * out,
+		size_t num
+) {
+	assert(prng);
+	assert(out || num == 0);
+
+	void (* fill)(FoxPRNG *, uint64_t *, size_t) = prng->vtable->fill;
+	if (fill) {
+		fill(prng, out, num);
+	} else {
+		uint64_t (* next)(FoxPRNG *) = prng->vtable->next;
+		for (size_t idx = 0; idx < num; idx++) out[idx] = next(prng);
+	}
+
+	return;
+}
+
+void FoxRandFillFloat(
+		FoxPRNG * prng,
+		float * out,
+		size_t num
+) {
+	assert(out || num == 0);
+
+	uint64_t chunk[FILL_CHUNK_SIZE];
+	while (num > 0) {
+		size_t chunkSize = FoxMin(num, (size_t)FILL_CHUNK_SIZE);
+		FoxRandFillU64(prng, chunk, chunkSize);
+		for (size_t idx = 0; idx < chunkSize; idx++) {
+			out[idx] = (chunk[idx] >> (64 - 24)) * 0x1.0p-24f;
+		}
+		out += chunkSize;
+		num -= chunkSize;
+	}
+
+	return;
+}
+
+void FoxRandFillDouble(
+		FoxPRNG * prng,
+		double * out,
+		size_t num
+) {
+	assert(out || num == 0);
+
+	uint64_t chunk[FILL_CHUNK_SIZE];
+	while (num > 0) {
+		size_t chunkSize = FoxMin(num, (size_t)FILL_CHUNK_SIZE);
+		FoxRandFillU64(prng, chunk, chunkSize);
+		for (size_t idx = 0; idx < chunkSize; idx++) {
+			out[idx] = (chunk[idx] >> (64 - 53)) * 0x1.0p-53;
+		}
+		out += chunkSize;
+		num -= chunkSize;
+	}
+
+	return;
+}
+
+void FoxRandFillBytes(
+		FoxPRNG * prng,
+		void * out,
+		size_t num
+) {
+	assert(out || num == 0);
+	unsigned char * bytes = out;
+
+	uint64_t chunk[FILL_CHUNK_SIZE];
+	while (num > 0) {
+		size_t numBytes = FoxMin(num, sizeof(chunk));
+		FoxRandFillU64(
+				prng,
+				chunk,
+				(numBytes + sizeof(uint64_t) - 1) / sizeof(uint64_t)
+		);
+		memcpy(bytes, chunk, numBytes);
+		bytes += numBytes;
+		num -= numBytes;
+	}
+
+	return;
+}
@@ -0,0 +1,585 @@
+/*
+ * Copyright 2020 Garrett Russell Fairburn
+ * 
+ * This file is part of the libfoxutils C library which is released
+ * under Apache 2.0. See file LICENSE for full license details.
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "foxutils/hash.h"
+#include "foxutils/math.h"
+#include "foxutils/rcumap.h"
+
+
+
+/* ----- PRIVATE MACROS ----- */
+
+#define NODE_ALIGN 8ul
+
+#define NodeKey(node) ((void *)(node)->data)
+
+#define NodeElem(map, node) ((void *)((node)->data + (map)->elemOffset))
+
+#define NodeSize(map) (sizeof(Node) + (map)->elemOffset + (map)->elemSize)
+
+#define LoadAcquire(ptr) atomic_load_explicit((ptr), memory_order_acquire)
+
+#define LoadRelaxed(ptr) atomic_load_explicit((ptr), memory_order_relaxed)
+
+#define StoreRelease(ptr, val) \
+	atomic_store_explicit((ptr), (val), memory_order_release)
+
+#define StoreRelaxed(ptr, val) \
+	atomic_store_explicit((ptr), (val), memory_order_relaxed)
+
+
+
+/* ----- PRIVATE TYPES ----- */
+
+typedef struct Node {
+	struct Node * _Atomic next;
+	uint64_t hash;
+	unsigned char data[];
+} Node;
+
+typedef struct FoxRcuMapTable {
+	size_t slotIdxMask;
+	Node * _Atomic slots[];
+} Table;
+
+typedef enum RetiredKind {
+	RETIRED_NODE, /* Unlinked node which still owns its key. */
+	RETIRED_NODE_MOVED, /* Unlinked node whose key now belongs to another. */
+	RETIRED_TABLE /* Replaced table along with all of its nodes. */
+} RetiredKind;
+
+typedef struct Retired {
+	void * ptr;
+	uint64_t epoch;
+	RetiredKind kind;
+} Retired;
+
+
+
+/* ----- PRIVATE FUNCTIONS ----- */
+
+static inline size_t AlignUp(size_t val) {
+	return (val + NODE_ALIGN - 1) & ~(NODE_ALIGN - 1);
+}
+
+static inline uint64_t KeyHash(
+		FoxRcuMap * map,
+		const void * key
+) {
+	uint64_t (* keyHash)(const void *) = map->keyHash;
+	if (keyHash) return keyHash(key);
+
+	return FoxHashKeySeeded(key, map->keySize, 0);
+}
+
+static inline bool KeyEqual(
+		FoxRcuMap * map,
+		const void * key,
+		const void * nodeKey
+) {
+	int (* keyCompare)(const void *, const void *) = map->keyCompare;
+
+	return (
+			(keyCompare) ?
+			keyCompare(key, nodeKey)
+			: memcmp(key, nodeKey, map->keySize)
+	) == 0;
+}
+
+static Table * TableNew(size_t numSlots) {
+	Table * table = calloc(1, sizeof(Table) + sizeof(Node *) * numSlots);
+	assert(table);
+	table->slotIdxMask = numSlots - 1;
+
+	return table;
+}
+
+static void TableFree(Table * table) {
+	size_t numSlots = table->slotIdxMask + 1;
+	for (size_t idx = 0; idx < numSlots; idx++) {
+		Node * node = LoadRelaxed(&table->slots[idx]);
+		while (node) {
+			Node * next = LoadRelaxed(&node->next);
+			free(node);
+			node = next;
+		}
+	}
+	free(table);
+
+	return;
+}
+
+static void FreeRetired(
+		FoxRcuMap * map,
+		Retired * retired
+) {
+	switch (retired->kind) {
+		case RETIRED_NODE:
+			if (map->keyDeinit) map->keyDeinit(NodeKey((Node *)retired->ptr));
+			free(retired->ptr);
+			break;
+		case RETIRED_NODE_MOVED:
+			free(retired->ptr);
+			break;
+		case RETIRED_TABLE:
+			TableFree(retired->ptr);
+			break;
+	}
+
+	return;
+}
+
+/*
+ * Hand memory which readers may still be using over to reclamation. Bumping
+ * the global epoch afterwards means that any reader which announces the new
+ * epoch can no longer see it.
+ */
+static void Retire(
+		FoxRcuMap * map,
+		void * ptr,
+		RetiredKind kind
+) {
+	Retired * retired = FoxArrayPush(&map->retired);
+	retired->ptr = ptr;
+	retired->kind = kind;
+	retired->epoch = atomic_fetch_add(&map->epoch, 1);
+
+	return;
+}
+
+static void Reclaim(FoxRcuMap * map) {
+	FoxArray * retired = &map->retired;
+	size_t numRetired = FoxArraySize(retired);
+	if (numRetired == 0) return;
+
+	/* Find oldest epoch which an online reader may still be in. */
+	atomic_thread_fence(memory_order_seq_cst);
+	uint64_t minEpoch = UINT64_MAX;
+	size_t numReaders = FoxArraySize(&map->readers);
+	for (unsigned int idx = 0; idx < numReaders; idx++) {
+		FoxRcuMapReader * reader = *(FoxRcuMapReader **)FoxArrayIndex(
+				&map->readers,
+				idx
+		);
+		uint64_t epoch = atomic_load(&reader->epoch);
+		if (epoch != 0) minEpoch = FoxMin(minEpoch, epoch);
+	}
+
+	/* Free (and compact away) everything retired before that epoch. */
+	unsigned int keepIdx = 0;
+	for (unsigned int idx = 0; idx < numRetired; idx++) {
+		Retired * entry = FoxArrayIndex(retired, idx);
+		if (entry->epoch < minEpoch) {
+			FreeRetired(map, entry);
+		} else {
+			*(Retired *)FoxArrayIndex(retired, keepIdx++) = *entry;
+		}
+	}
+	while (FoxArraySize(retired) > keepIdx) FoxArrayPop(retired, NULL);
+
+	return;
+}
+
+static inline Node * NodeNew(
+		FoxRcuMap * map,
+		uint64_t hash,
+		const void * elem
+) {
+	Node * node = malloc(NodeSize(map));
+	assert(node);
+	StoreRelaxed(&node->next, NULL);
+	node->hash = hash;
+	memcpy(NodeElem(map, node), elem, map->elemSize);
+
+	return node;
+}
+
+/*
+ * Find the link which points to a key's node (or the null link terminating
+ * its slot's chain). Only writers may use this.
+ */
+static Node * _Atomic * FindLink(
+		FoxRcuMap * map,
+		Table * table,
+		const void * key,
+		uint64_t hash
+) {
+	Node * _Atomic * link = &table->slots[hash & table->slotIdxMask];
+	Node * node;
+	while ((node = LoadRelaxed(link))) {
+		if (node->hash == hash && KeyEqual(map, key, NodeKey(node))) break;
+		link = &node->next;
+	}
+
+	return link;
+}
+
+/*
+ * Replace the current table with a larger one. Readers may still be walking
+ * the old chains, so every node is copied rather than relinked, and the old
+ * table retires with all of its nodes once the new one is published.
+ */
+static void Expand(
+		FoxRcuMap * map,
+		Table * oldTable
+) {
+	size_t oldNumSlots = oldTable->slotIdxMask + 1;
+	Table * table = TableNew(
+			FoxRoundUpPow2((size_t)(oldNumSlots * map->growRate))
+	);
+	size_t nodeSize = NodeSize(map);
+
+	for (size_t idx = 0; idx < oldNumSlots; idx++) {
+		Node * oldNode = LoadRelaxed(&oldTable->slots[idx]);
+		for (; oldNode; oldNode = LoadRelaxed(&oldNode->next)) {
+			Node * node = malloc(nodeSize);
+			assert(node);
+			memcpy(node, oldNode, nodeSize);
+			Node * _Atomic * slot = &table->slots[node->hash & table->slotIdxMask];
+			StoreRelaxed(&node->next, LoadRelaxed(slot));
+			StoreRelaxed(slot, node);
+		}
+	}
+
+	StoreRelease(&map->table, table);
+	Retire(map, oldTable, RETIRED_TABLE);
+
+	return;
+}
+
+
+
+/* ----- PUBLIC FUNCTIONS ----- */
+
+FoxRcuMap * FoxRcuMapNew(
+		size_t keySize,
+		size_t elemSize,
+		size_t initSlots,
+		float growRate,
+		float lfThresh,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void *, const void *),
+		void (* keyDeinit)(void *)
+) {
+	FoxRcuMap * map = calloc(1, sizeof(FoxRcuMap));
+	FoxRcuMapInit(
+			map,
+			keySize,
+			elemSize,
+			initSlots,
+			growRate,
+			lfThresh,
+			keyHash,
+			keyCompare,
+			keyCopy,
+			keyDeinit
+	);
+
+	return map;
+}
+
+void FoxRcuMapFree(FoxRcuMap * map) {
+	FoxRcuMapDeinit(map);
+	free(map);
+
+	return;
+}
+
+void FoxRcuMapInit(
+		FoxRcuMap * map,
+		size_t keySize,
+		size_t elemSize,
+		size_t initSlots,
+		float growRate,
+		float lfThresh,
+		uint64_t (* keyHash)(const void * key),
+		int (* keyCompare)(const void * keyA, const void * keyB),
+		void (* keyCopy)(void *, const void *),
+		void (* keyDeinit)(void *)
+) {
+	assert(map);
+	assert(keySize > 0);
+	assert(elemSize > 0);
+	assert(initSlots <= (1ul << (sizeof(size_t) * 8 - 1)));
+	assert(growRate > 1.0f);
+
+	/* Initialize scalar members. */
+	map->keySize = keySize;
+	map->elemSize = elemSize;
+	map->elemOffset = AlignUp(keySize);
+	map->growRate = growRate;
+	map->lfThresh = lfThresh;
+	atomic_init(&map->epoch, 1);
+	atomic_init(&map->size, 0);
+
+	/* Initialize key functions. */
+	map->keyHash = keyHash;
+	map->keyCompare = keyCompare;
+	map->keyCopy = keyCopy;
+	map->keyDeinit = keyDeinit;
+
+	/* Initialize synchronization state. */
+	int err = pthread_mutex_init(&map->writeLock, NULL);
+	assert(err == 0);
+	(void)err;
+	FoxArrayInit(
+			&map->readers,
+			sizeof(FoxRcuMapReader *),
+			FOXARRAY_DEF_INITCAP,
+			FOXARRAY_DEF_GROWRATE
+	);
+	FoxArrayInit(
+			&map->retired,
+			sizeof(Retired),
+			FOXARRAY_DEF_INITCAP,
+			FOXARRAY_DEF_GROWRATE
+	);
+
+	/* Initialize table. */
+	atomic_init(&map->table, TableNew(FoxMax(FoxRoundUpPow2(initSlots), 1ul)));
+
+	return;
+}
+
+void FoxRcuMapDeinit(FoxRcuMap * map) {
+	assert(map);
+
+	/* Free all retired memory regardless of readers. */
+	FoxArray * retired = &map->retired;
+	size_t numRetired = FoxArraySize(retired);
+	for (unsigned int idx = 0; idx < numRetired; idx++) {
+		FreeRetired(map, FoxArrayIndex(retired, idx));
+	}
+	FoxArrayDeinit(retired);
+
+	/* Free current table. */
+	Table * table = LoadRelaxed(&map->table);
+	void (* keyDeinit)(void *) = map->keyDeinit;
+	if (keyDeinit) {
+		for (size_t idx = 0; idx <= table->slotIdxMask; idx++) {
+			Node * node = LoadRelaxed(&table->slots[idx]);
+			for (; node; node = LoadRelaxed(&node->next)) {
+				keyDeinit(NodeKey(node));
+			}
+		}
+	}
+	TableFree(table);
+
+	/* Free readers. */
+	FoxArray * readers = &map->readers;
+	size_t numReaders = FoxArraySize(readers);
+	for (unsigned int idx = 0; idx < numReaders; idx++) {
+		free(*(FoxRcuMapReader **)FoxArrayIndex(readers, idx));
+	}
+	FoxArrayDeinit(readers);
+
+	pthread_mutex_destroy(&map->writeLock);
+	*map = (FoxRcuMap){0};
+
+	return;
+}
+
+size_t FoxRcuMapSize(FoxRcuMap * map) {
+	assert(map);
+
+	return LoadRelaxed(&map->size);
+}
+
+FoxRcuMapReader * FoxRcuMapRegisterReader(FoxRcuMap * map) {
+	assert(map);
+
+	FoxRcuMapReader * reader = aligned_alloc(
+			_Alignof(FoxRcuMapReader),
+			sizeof(FoxRcuMapReader)
+	);
+	assert(reader);
+	atomic_init(&reader->epoch, 0);
+
+	pthread_mutex_lock(&map->writeLock);
+	*(FoxRcuMapReader **)FoxArrayPush(&map->readers) = reader;
+	pthread_mutex_unlock(&map->writeLock);
+
+	FoxRcuMapQuiescent(map, reader);
+
+	return reader;
+}
+
+void FoxRcuMapUnregisterReader(
+		FoxRcuMap * map,
+		FoxRcuMapReader * reader
+) {
+	assert(map);
+	assert(reader);
+
+	pthread_mutex_lock(&map->writeLock);
+	FoxArray * readers = &map->readers;
+	size_t numReaders = FoxArraySize(readers);
+	for (unsigned int idx = 0; idx < numReaders; idx++) {
+		if (*(FoxRcuMapReader **)FoxArrayIndex(readers, idx) == reader) {
+			FoxArrayRemove(readers, idx, NULL);
+			break;
+		}
+	}
+	Reclaim(map);
+	pthread_mutex_unlock(&map->writeLock);
+	free(reader);
+
+	return;
+}
+
+void FoxRcuMapQuiescent(
+		FoxRcuMap * map,
+		FoxRcuMapReader * reader
+) {
+	assert(map);
+	assert(reader);
+
+	/*
+	 * The fence pairs with the one in Reclaim(): either a writer sees this
+	 * announcement, or this reader sees everything that writer unlinked.
+	 */
+	atomic_store(&reader->epoch, atomic_load(&map->epoch));
+	atomic_thread_fence(memory_order_seq_cst);
+
+	return;
+}
+
+void FoxRcuMapOffline(
+		FoxRcuMap * map,
+		FoxRcuMapReader * reader
+) {
+	assert(map);
+	assert(reader);
+
+	StoreRelease(&reader->epoch, 0);
+
+	return;
+}
+
+const void * FoxRcuMapIndex(
+		FoxRcuMap * map,
+		const void * key
+) {
+	assert(map);
+	assert(key);
+
+	uint64_t hash = KeyHash(map, key);
+	Table * table = LoadAcquire(&map->table);
+	Node * node = LoadAcquire(&table->slots[hash & table->slotIdxMask]);
+	for (; node; node = LoadAcquire(&node->next)) {
+		if (node->hash == hash && KeyEqual(map, key, NodeKey(node))) {
+			return NodeElem(map, node);
+		}
+	}
+
+	return NULL;
+}
+
+void FoxRcuMapInsert(
+		FoxRcuMap * map,
+		const void * key,
+		const void * elem
+) {
+	assert(map);
+	assert(key);
+	assert(elem);
+
+	uint64_t hash = KeyHash(map, key);
+	Node * node = NodeNew(map, hash, elem);
+
+	pthread_mutex_lock(&map->writeLock);
+	Table * table = LoadRelaxed(&map->table);
+	Node * _Atomic * link = FindLink(map, table, key, hash);
+	Node * oldNode = LoadRelaxed(link);
+	if (oldNode) {
+		/* Replace old node, taking over its key. */
+		memcpy(NodeKey(node), NodeKey(oldNode), map->keySize);
+		StoreRelaxed(&node->next, LoadRelaxed(&oldNode->next));
+		StoreRelease(link, node);
+		Retire(map, oldNode, RETIRED_NODE_MOVED);
+	} else {
+		/* Copy key and publish new node at end of chain. */
+		void (* keyCopy)(void *, const void *) = map->keyCopy;
+		if (keyCopy) {
+			keyCopy(NodeKey(node), key);
+		} else {
+			memcpy(NodeKey(node), key, map->keySize);
+		}
+		StoreRelease(link, node);
+
+		/* Expand map if necessary. */
+		size_t size = LoadRelaxed(&map->size) + 1;
+		StoreRelaxed(&map->size, size);
+		float loadFactor = (float)size / (float)(table->slotIdxMask + 1);
+		if (map->lfThresh > 0.0f && loadFactor >= map->lfThresh) {
+			Expand(map, table);
+		}
+	}
+	Reclaim(map);
+	pthread_mutex_unlock(&map->writeLock);
+
+	return;
+}
+
+bool FoxRcuMapRemove(
+		FoxRcuMap * map,
+		const void * key,
+		void * elem
+) {
+	assert(map);
+	assert(key);
+
+	uint64_t hash = KeyHash(map, key);
+
+	pthread_mutex_lock(&map->writeLock);
+	Table * table = LoadRelaxed(&map->table);
+	Node * _Atomic * link = FindLink(map, table, key, hash);
+	Node * node = LoadRelaxed(link);
+	if (node) {
+		if (elem) memcpy(elem, NodeElem(map, node), map->elemSize);
+		StoreRelease(link, LoadRelaxed(&node->next));
+		StoreRelaxed(&map->size, LoadRelaxed(&map->size) - 1);
+		Retire(map, node, RETIRED_NODE);
+	}
+	Reclaim(map);
+	pthread_mutex_unlock(&map->writeLock);
+
+	return node != NULL;
+}
+
+void FoxRcuMapReclaim(FoxRcuMap * map) {
+	assert(map);
+
+	pthread_mutex_lock(&map->writeLock);
+	Reclaim(map);
+	pthread_mutex_unlock(&map->writeLock);
+
+	return;
+}
+
+void FoxRcuMapForEachPair(
+		FoxRcuMap * map,
+		bool (* callback)(const void * key, const void * elem, void * ctx),
+		void * ctx
+) {
+	assert(map);
+	assert(callback);
+
+	Table * table = LoadAcquire(&map->table);
+	for (size_t idx = 0; idx <= table->slotIdxMask; idx++) {
+		Node * node = LoadAcquire(&table->slots[idx]);
+		for (; node; node = LoadAcquire(&node->next)) {
+			if (!callback(NodeKey(node), NodeElem(map, node), ctx)) return;
+		}
+	}
+
+	return;
+}
@@ -15,7 +15,8 @@
 
 static FoxPRNGVTable vtable = {
 	.seed = (void (*)(FoxPRNG *, uint64_t))FoxSplitMix64Seed,
-	.next = (uint64_t (*)(FoxPRNG *))FoxSplitMix64Next
+	.next = (uint64_t (*)(FoxPRNG *))FoxSplitMix64Next,
+	.fill = (void (*)(FoxPRNG *, uint64_t *, size_t))FoxSplitMix64Fill
 };
 
 
@@ -65,6 +66,24 @@ void FoxSplitMix64Seed(
 	return;
 }
 
+void FoxSplitMix64Fill(
+		FoxSplitMix64 * prng,
+		uint64_t * out,
+		size_t num
+) {
+	assert(prng);
+	assert(out || num == 0);
+
+	/* Keep the state local, so that it may stay in registers. */
+	uint64_t state = prng->state;
+	for (size_t idx = 0; idx < num; idx++) {
+		out[idx] = FoxSplitMix64Primitive(&state);
+	}
+	prng->state = state;
+
+	return;
+}
+
 uint64_t FoxSplitMix64Next(FoxSplitMix64 * prng) {
 	return FoxSplitMix64Primitive(&prng->state);
 }
@@ -13,17 +13,83 @@
 
 
 
+/* ----- PRIVATE MACROS ----- */
+
+/* Stored keys are prefixed by their lengths. */
+#define StoredLength(str) (((const size_t *)(str))[-1])
+
+#define StoredSize(len) (sizeof(size_t) + (len) + 1)
+
+
+
+/* ----- PRIVATE TYPES ----- */
+
+typedef struct StringSlice {
+	const char * str;
+	size_t len;
+} StringSlice;
+
+
+
 /* ----- PRIVATE FUNCTIONS ----- */
 
-static unsigned int StringKeyHash(const char ** key) {
-	return FoxHashString(*key);
+/*
+ * FoxHashString*() agree with FoxHashMem*(), which FoxStringMapHash() relies
+ * on.
+ */
+static uint64_t StringKeyHashSeeded(
+		const char ** key,
+		uint64_t seed
+) {
+	return FoxHashStringSeeded(*key, seed);
 }
 
+static uint64_t StringKeyHashKeyed(
+		const char ** key,
+		const FoxHashKey * hashKey
+) {
+	return FoxHashStringKeyed(*key, hashKey);
+}
+
+/*
+ * keyB is always a stored key, but keyA may be a caller's plain string, so
+ * only keyB's length can be read from its prefix.
+ */
 static int StringKeyCompare(
 		const char ** keyA,
 		const char ** keyB
 ) {
-	return strcmp(*keyA, *keyB);
+	size_t lenA = strlen(*keyA);
+	size_t lenB = StoredLength(*keyB);
+	if (lenA != lenB) return (lenA < lenB) ? -1 : 1;
+
+	return memcmp(*keyA, *keyB, lenA);
+}
+
+static int StringSliceCompare(
+		const StringSlice * slice,
+		const char ** key
+) {
+	size_t len = slice->len;
+	if (StoredLength(*key) != len) return 1;
+
+	return memcmp(slice->str, *key, len);
+}
+
+/*
+ * Store a string of len characters (plus a terminator) after its length in
+ * mem, which must hold StoredSize(len) bytes.
+ */
+static char * StoreKey(
+		size_t * mem,
+		const char * str,
+		size_t len
+) {
+	*mem = len;
+	char * key = memcpy(mem + 1, str, len);
+	key[len] = '\0';
+
+	return key;
 }
 
 static void StringKeyCopy(
@@ -31,15 +97,26 @@ static void StringKeyCopy(
 		const char ** key
 ) {
 	const char * tmpKey = *key;
-	char * tmpCopy = malloc(strlen(tmpKey) + 1);
-	assert(tmpCopy);
-	*copy = strcpy(tmpCopy, tmpKey);
+	size_t len = strlen(tmpKey);
+	size_t * mem = malloc(StoredSize(len));
+	assert(mem);
+	*copy = StoreKey(mem, tmpKey, len);
+
+	return;
+}
+
+static void StringKeyArenaCopy(
+		char ** copy,
+		const char ** key,
+		FoxArena * arena
+) {
+	*copy = (char *)FoxStringMapKeyAlloc(arena, *key, strlen(*key));
 
 	return;
 }
 
 static void StringKeyDeinit(char ** key) {
-	free(*key);
+	free((size_t *)*key - 1);
 
 	return;
 }
@@ -54,17 +131,11 @@ FoxMap * FoxStringMapNew(
 		float growRate,
 		float lfThresh
 ) {
-	return FoxMapNew(
-			sizeof(const char *),
-			elemSize,
-			initSlots,
-			growRate,
-			lfThresh,
-			(unsigned int (*)(const void *))&StringKeyHash,
-			(int (*)(const void *, const void *))&StringKeyCompare,
-			(void (*)(void *, const void *))&StringKeyCopy,
-			(void (*)(void *))&StringKeyDeinit
-	);
+	FoxMap * map = malloc(sizeof(FoxMap));
+	assert(map);
+	FoxStringMapInit(map, elemSize, initSlots, growRate, lfThresh);
+
+	return map;
 }
 
 void FoxStringMapInit(
@@ -74,18 +145,111 @@ void FoxStringMapInit(
 		float growRate,
 		float lfThresh
 ) {
-	FoxMapInit(
+	FoxMapInit64(
 			map,
 			sizeof(const char *),
 			elemSize,
 			initSlots,
 			growRate,
 			lfThresh,
-			(unsigned int (*)(const void *))&StringKeyHash,
+			NULL,
 			(int (*)(const void *, const void *))&StringKeyCompare,
 			(void (*)(void *, const void *))&StringKeyCopy,
 			(void (*)(void *))&StringKeyDeinit
 	);
+	FoxMapSetSeededHash(
+			map,
+			(uint64_t (*)(const void *, uint64_t))&StringKeyHashSeeded,
+			(uint64_t (*)(const void *, const FoxHashKey *))&StringKeyHashKeyed
+	);
+	FoxMapSetKeyedHash(map, true);
+
+	return;
+}
+
+void FoxStringMapInitBorrowed(
+		FoxMap * map,
+		size_t elemSize,
+		size_t initSlots,
+		float growRate,
+		float lfThresh
+) {
+	FoxStringMapInit(map, elemSize, initSlots, growRate, lfThresh);
+	map->keyCopy = NULL;
+	map->keyDeinit = NULL;
 
 	return;
 }
+
+const char * FoxStringMapKeyAlloc(
+		FoxArena * arena,
+		const char * str,
+		size_t len
+) {
+	assert(arena);
+	assert(str);
+
+	size_t * mem = FoxArenaAlloc(arena, StoredSize(len), _Alignof(size_t));
+
+	return StoreKey(mem, str, len);
+}
+
+size_t FoxStringMapKeyLength(const char * key) {
+	assert(key);
+
+	return StoredLength(key);
+}
+
+void FoxStringMapUseArena(FoxMap * map) {
+	FoxMapSetKeyArena(
+			map,
+			(void (*)(void *, const void *, FoxArena *))&StringKeyArenaCopy,
+			FOXARENA_DEF_CHUNKSIZE
+	);
+
+	return;
+}
+
+uint64_t FoxStringMapHash(
+		FoxMap * map,
+		const char * str,
+		size_t len
+) {
+	assert(map);
+	assert(str);
+
+	if (map->keyedHash) return FoxHashMemKeyed(str, len, &map->hashKey);
+
+	return FoxHashMemSeeded(str, len, map->hashKey.k0);
+}
+
+void * FoxStringMapIndexN(
+		FoxMap * map,
+		const char * str,
+		size_t len
+) {
+	return FoxStringMapIndexHashed(
+			map,
+			str,
+			len,
+			FoxStringMapHash(map, str, len)
+	);
+}
+
+void * FoxStringMapIndexHashed(
+		FoxMap * map,
+		const char * str,
+		size_t len,
+		uint64_t hash
+) {
+	assert(map);
+	assert(str);
+	StringSlice slice = {.str = str, .len = len};
+
+	return FoxMapIndexHashedCompare(
+			map,
+			&slice,
+			hash,
+			(int (*)(const void *, const void *))&StringSliceCompare
+	);
+}
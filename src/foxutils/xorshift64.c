@@ -15,7 +15,8 @@
 
 static FoxPRNGVTable vtable = {
 	.seed = (void (*)(FoxPRNG *, uint64_t))FoxXorshift64Seed,
-	.next = (uint64_t (*)(FoxPRNG *))FoxXorshift64Next
+	.next = (uint64_t (*)(FoxPRNG *))FoxXorshift64Next,
+	.fill = (void (*)(FoxPRNG *, uint64_t *, size_t))FoxXorshift64Fill
 };
 
 
@@ -65,6 +66,24 @@ void FoxXorshift64Seed(
 	return;
 }
 
+void FoxXorshift64Fill(
+		FoxXorshift64 * prng,
+		uint64_t * out,
+		size_t num
+) {
+	assert(prng);
+	assert(out || num == 0);
+
+	/* Keep the state local, so that it may stay in registers. */
+	uint64_t state = prng->state;
+	for (size_t idx = 0; idx < num; idx++) {
+		out[idx] = FoxXorshift64Primitive(&state);
+	}
+	prng->state = state;
+
+	return;
+}
+
 uint64_t FoxXorshift64Next(FoxXorshift64 * prng) {
 	return FoxXorshift64Primitive(&prng->state);
 }
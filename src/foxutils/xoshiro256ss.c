@@ -35,7 +35,8 @@ const uint64_t FOXXOSHIRO256SS_JUMPPOLY_2_192[4] = {
 
 static FoxPRNGVTable vtable = {
 	.seed = (void (*)(FoxPRNG *, uint64_t))FoxXoshiro256SSSeed,
-	.next = (uint64_t (*)(FoxPRNG *))FoxXoshiro256SSNext
+	.next = (uint64_t (*)(FoxPRNG *))FoxXoshiro256SSNext,
+	.fill = (void (*)(FoxPRNG *, uint64_t *, size_t))FoxXoshiro256SSFill
 };
 
 
@@ -88,13 +89,39 @@ void FoxXoshiro256SSSeed(
 	return;
 }
 
+void FoxXoshiro256SSFill(
+		FoxXoshiro256SS * prng,
+		uint64_t * out,
+		size_t num
+) {
+	assert(prng);
+	assert(out || num == 0);
+
+	/* Keep the state local, so that it may stay in registers. */
+	uint64_t state[4] = {
+		prng->state[0],
+		prng->state[1],
+		prng->state[2],
+		prng->state[3]
+	};
+	for (size_t idx = 0; idx < num; idx++) {
+		out[idx] = FoxXoshiro256SSPrimitive(state);
+	}
+	prng->state[0] = state[0];
+	prng->state[1] = state[1];
+	prng->state[2] = state[2];
+	prng->state[3] = state[3];
+
+	return;
+}
+
 uint64_t FoxXoshiro256SSNext(FoxXoshiro256SS * prng) {
 	return FoxXoshiro256SSPrimitive(prng->state);
 }
 
 void FoxXoshiro256SSJump(
 		FoxXoshiro256SS * prng,
-		const uint64_t jumpPoly[]
+		const uint64_t jumpPoly[4]
 ) {
 	assert(prng);
 	assert(jumpPoly);